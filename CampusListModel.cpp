@@ -0,0 +1,147 @@
+#include "CampusListModel.h"
+#include <QColor>
+#include <algorithm>
+
+CampusListModel::CampusListModel(QObject *parent)
+    : QAbstractListModel(parent), loaded(0), tripMode(false) { }
+
+int CampusListModel::idFor(const QString &college) {
+    auto it = ids.constFind(college);
+    if (it != ids.constEnd())
+        return it.value();
+
+    int id = static_cast<int>(names.size());
+    names.push_back(college);
+    ids.insert(college, id);
+    selected.push_back(false);
+    return id;
+}
+
+void CampusListModel::resetEntries(std::vector<Entry> &&rows, bool trip) {
+    beginResetModel();
+    entries = std::move(rows);
+    tripMode = trip;
+    std::fill(selected.begin(), selected.end(), false);
+    if (trip) {
+        for (const Entry &e : entries)
+            selected[e.collegeId] = true;
+    }
+    loaded = std::min(static_cast<int>(entries.size()), static_cast<int>(FetchBatch));
+    endResetModel();
+}
+
+void CampusListModel::showDistances(const QString &startCollege,
+                                    const std::vector<std::pair<QString, double>> &others) {
+    std::vector<Entry> rows;
+    rows.reserve(others.size() + 1);
+    rows.push_back(Entry{idFor(startCollege), 0, false});
+    for (const auto &other : others) {
+        if (other.first == startCollege)
+            continue;
+        rows.push_back(Entry{idFor(other.first), other.second, false});
+    }
+    resetEntries(std::move(rows), false);
+}
+
+void CampusListModel::showTrip(const std::vector<QString> &path, const std::vector<double> &legs,
+                               const std::vector<bool> &estimated) {
+    std::vector<Entry> rows;
+    rows.reserve(path.size());
+    for (size_t i = 0; i < path.size(); i++) {
+        rows.push_back(Entry{idFor(path[i]), i < legs.size() ? legs[i] : 0,
+                             i < estimated.size() && estimated[i]});
+    }
+    resetEntries(std::move(rows), true);
+}
+
+void CampusListModel::toggleSelected(int row) {
+    if (row <= 0 || row >= static_cast<int>(entries.size()))
+        return;
+    int id = entries[row].collegeId;
+    selected[id] = !selected[id];
+    if (row < loaded) {
+        QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {Qt::BackgroundRole});
+    }
+}
+
+bool CampusListModel::isSelected(int row) const {
+    if (row < 0 || row >= static_cast<int>(entries.size()))
+        return false;
+    return selected[entries[row].collegeId];
+}
+
+bool CampusListModel::isReference(int row) const {
+    return row == 0 && !entries.empty();
+}
+
+void CampusListModel::ensureLoaded(int row) {
+    int target = std::min(row + 1, static_cast<int>(entries.size()));
+    if (target <= loaded)
+        return;
+    beginInsertRows(QModelIndex(), loaded, target - 1);
+    loaded = target;
+    endInsertRows();
+}
+
+int CampusListModel::entryCount() const {
+    return static_cast<int>(entries.size());
+}
+
+QString CampusListModel::collegeAt(int row) const {
+    if (row < 0 || row >= static_cast<int>(entries.size()))
+        return QString();
+    return names[entries[row].collegeId];
+}
+
+std::vector<QString> CampusListModel::selectedColleges() const {
+    std::vector<QString> colleges;
+    for (int i = 1; i < static_cast<int>(entries.size()); i++) {
+        if (selected[entries[i].collegeId])
+            colleges.push_back(names[entries[i].collegeId]);
+    }
+    return colleges;
+}
+
+int CampusListModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : loaded;
+}
+
+QVariant CampusListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= loaded)
+        return QVariant();
+
+    const Entry &e = entries[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+        if (index.row() == 0)
+            return names[e.collegeId] + (tripMode ? " - (Start, 0 miles)" : " - (Start)");
+        if (e.estimated)
+            return QString("%1 - ~%2 miles (estimated)").arg(names[e.collegeId]).arg(e.miles, 0, 'f', 0);
+        return QString("%1 - %2 miles").arg(names[e.collegeId]).arg(e.miles);
+    case Qt::BackgroundRole:
+        if (selected[e.collegeId])
+            return QColor(Qt::blue);
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags CampusListModel::flags(const QModelIndex &index) const {
+    Qt::ItemFlags f = QAbstractListModel::flags(index);
+    // The start college is only a header until a trip has been planned.
+    if (index.isValid() && index.row() == 0 && !tripMode)
+        f &= ~Qt::ItemIsSelectable;
+    return f;
+}
+
+bool CampusListModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && loaded < static_cast<int>(entries.size());
+}
+
+void CampusListModel::fetchMore(const QModelIndex &parent) {
+    if (parent.isValid())
+        return;
+    ensureLoaded(loaded + FetchBatch - 1);
+}
@@ -0,0 +1,76 @@
+#ifndef CAMPUSLISTMODEL_H
+#define CAMPUSLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <vector>
+#include <utility>
+
+// List model behind the distances/trip view.
+// Rows refer to colleges by integer id and the highlight state lives in a bitset
+// indexed by that id, so nothing has to be recovered from display text or colours.
+// Display strings are only built when the view asks for a row, and rows are handed
+// to the view in batches through canFetchMore/fetchMore.
+class CampusListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit CampusListModel(QObject *parent = nullptr);
+
+    // Shows the start college followed by the distance from it to every other college.
+    void showDistances(const QString &startCollege,
+                       const std::vector<std::pair<QString, double>> &others);
+    // Shows a planned trip: legs[i] is the distance from path[i - 1] to path[i], marked
+    // as approximate where estimated[i] is set. Every stop of a planned trip is highlighted.
+    void showTrip(const std::vector<QString> &path, const std::vector<double> &legs,
+                  const std::vector<bool> &estimated);
+
+    // Flips the highlight of a row; the start college cannot be toggled.
+    void toggleSelected(int row);
+    bool isSelected(int row) const;
+    bool isReference(int row) const;
+    // Makes sure the first row + 1 rows have been handed to the view.
+    void ensureLoaded(int row);
+
+    // Total number of rows, including those not yet fetched by the view.
+    int entryCount() const;
+    QString collegeAt(int row) const;
+    // Names of the highlighted colleges, excluding the start college.
+    std::vector<QString> selectedColleges() const;
+
+    // QAbstractListModel interface
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    struct Entry {
+        int collegeId;
+        double miles;
+        // The miles are a coordinate estimate, not a recorded distance.
+        bool estimated;
+    };
+
+    // Rows handed to the view per fetchMore call.
+    static const int FetchBatch = 256;
+
+    // College dictionary: id -> name and name -> id.
+    std::vector<QString> names;
+    QHash<QString, int> ids;
+    // Highlight bitset indexed by college id.
+    std::vector<bool> selected;
+    // Rows in display order; row 0 is always the start college.
+    std::vector<Entry> entries;
+    // Number of rows the view currently knows about.
+    int loaded;
+    // True while showing a planned trip rather than distances from the start.
+    bool tripMode;
+
+    int idFor(const QString &college);
+    void resetEntries(std::vector<Entry> &&rows, bool trip);
+};
+
+#endif // CAMPUSLISTMODEL_H
@@ -0,0 +1,180 @@
+#include "CampusSpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double DegreesToRadians = 3.14159265358979323846 / 180.0;
+
+double squaredDistance(const double* a, const double* b) {
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+}
+
+CampusSpatialIndex::CampusSpatialIndex() { }
+
+void CampusSpatialIndex::toUnitVector(double latitude, double longitude, double* xyz) {
+    double lat = latitude * DegreesToRadians;
+    double lon = longitude * DegreesToRadians;
+    xyz[0] = std::cos(lat) * std::cos(lon);
+    xyz[1] = std::cos(lat) * std::sin(lon);
+    xyz[2] = std::sin(lat);
+}
+
+double CampusSpatialIndex::chordToMiles(double chord) {
+    // Angle subtended by a chord of the unit sphere, times the radius.
+    return 2.0 * EarthRadiusMiles * std::asin(std::min(1.0, chord / 2.0));
+}
+
+double CampusSpatialIndex::milesToChord(double miles) {
+    double angle = std::min(miles / EarthRadiusMiles, 3.14159265358979323846);
+    return 2.0 * std::sin(angle / 2.0);
+}
+
+double CampusSpatialIndex::greatCircleMiles(double lat1, double lon1, double lat2, double lon2) {
+    double a[3], b[3];
+    toUnitVector(lat1, lon1, a);
+    toUnitVector(lat2, lon2, b);
+    return chordToMiles(std::sqrt(squaredDistance(a, b)));
+}
+
+void CampusSpatialIndex::build(const std::vector<CampusCoordinate>& campuses) {
+    tree.clear();
+    names.clear();
+    locations.clear();
+    ids.clear();
+
+    tree.reserve(campuses.size());
+    for (const CampusCoordinate& c : campuses) {
+        if (ids.contains(c.college))
+            continue;
+        int id = static_cast<int>(names.size());
+        names.push_back(c.college);
+        locations.emplace_back(c.latitude, c.longitude);
+        ids.insert(c.college, id);
+
+        Point p;
+        toUnitVector(c.latitude, c.longitude, p.xyz);
+        p.id = id;
+        tree.push_back(p);
+    }
+    buildRange(0, static_cast<int>(tree.size()), 0);
+}
+
+void CampusSpatialIndex::buildRange(int lo, int hi, int depth) {
+    if (hi - lo <= 1)
+        return;
+    int axis = depth % 3;
+    int mid = (lo + hi) / 2;
+    std::nth_element(tree.begin() + lo, tree.begin() + mid, tree.begin() + hi,
+                     [axis](const Point& a, const Point& b) { return a.xyz[axis] < b.xyz[axis]; });
+    buildRange(lo, mid, depth + 1);
+    buildRange(mid + 1, hi, depth + 1);
+}
+
+void CampusSpatialIndex::searchNearest(int lo, int hi, int depth, const double* target, int k, int exclude,
+                                       std::vector<std::pair<double, int>>& heap) const {
+    if (lo >= hi)
+        return;
+    int axis = depth % 3;
+    int mid = (lo + hi) / 2;
+    const Point& p = tree[mid];
+
+    if (p.id != exclude) {
+        double d2 = squaredDistance(target, p.xyz);
+        if (static_cast<int>(heap.size()) < k) {
+            heap.emplace_back(d2, p.id);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (d2 < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = std::make_pair(d2, p.id);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+
+    // Search the side containing the target first; only cross the splitting
+    // plane if it is closer than the current k-th best.
+    double diff = target[axis] - p.xyz[axis];
+    bool leftFirst = diff < 0;
+    if (leftFirst)
+        searchNearest(lo, mid, depth + 1, target, k, exclude, heap);
+    else
+        searchNearest(mid + 1, hi, depth + 1, target, k, exclude, heap);
+
+    if (static_cast<int>(heap.size()) < k || diff * diff < heap.front().first) {
+        if (leftFirst)
+            searchNearest(mid + 1, hi, depth + 1, target, k, exclude, heap);
+        else
+            searchNearest(lo, mid, depth + 1, target, k, exclude, heap);
+    }
+}
+
+void CampusSpatialIndex::searchRadius(int lo, int hi, int depth, const double* target, double chord2, int exclude,
+                                      std::vector<std::pair<double, int>>& found) const {
+    if (lo >= hi)
+        return;
+    int axis = depth % 3;
+    int mid = (lo + hi) / 2;
+    const Point& p = tree[mid];
+
+    double d2 = squaredDistance(target, p.xyz);
+    if (d2 <= chord2 && p.id != exclude)
+        found.emplace_back(d2, p.id);
+
+    double diff = target[axis] - p.xyz[axis];
+    if (diff < 0 || diff * diff <= chord2)
+        searchRadius(lo, mid, depth + 1, target, chord2, exclude, found);
+    if (diff >= 0 || diff * diff <= chord2)
+        searchRadius(mid + 1, hi, depth + 1, target, chord2, exclude, found);
+}
+
+std::vector<std::pair<QString, double>> CampusSpatialIndex::toMiles(std::vector<std::pair<double, int>>& hits) const {
+    std::sort(hits.begin(), hits.end());
+    std::vector<std::pair<QString, double>> result;
+    result.reserve(hits.size());
+    for (const auto& hit : hits)
+        result.emplace_back(names[hit.second], chordToMiles(std::sqrt(hit.first)));
+    return result;
+}
+
+std::vector<std::pair<QString, double>> CampusSpatialIndex::nearest(const QString& college, int k) const {
+    auto it = ids.constFind(college);
+    if (it == ids.constEnd() || k <= 0)
+        return {};
+    const std::pair<double, double>& loc = locations[it.value()];
+    double target[3];
+    toUnitVector(loc.first, loc.second, target);
+    std::vector<std::pair<double, int>> heap;
+    heap.reserve(k);
+    searchNearest(0, static_cast<int>(tree.size()), 0, target, k, it.value(), heap);
+    return toMiles(heap);
+}
+
+std::vector<std::pair<QString, double>> CampusSpatialIndex::withinRadius(const QString& college,
+                                                                         double miles) const {
+    auto it = ids.constFind(college);
+    if (it == ids.constEnd() || miles < 0)
+        return {};
+    const std::pair<double, double>& loc = locations[it.value()];
+    double target[3];
+    toUnitVector(loc.first, loc.second, target);
+    double chord = milesToChord(miles);
+    std::vector<std::pair<double, int>> found;
+    searchRadius(0, static_cast<int>(tree.size()), 0, target, chord * chord, it.value(), found);
+    return toMiles(found);
+}
+
+double CampusSpatialIndex::lowerBoundMiles(const QString& a, const QString& b) const {
+    auto ia = ids.constFind(a);
+    auto ib = ids.constFind(b);
+    if (ia == ids.constEnd() || ib == ids.constEnd())
+        return -1;
+    const std::pair<double, double>& la = locations[ia.value()];
+    const std::pair<double, double>& lb = locations[ib.value()];
+    return greatCircleMiles(la.first, la.second, lb.first, lb.second);
+}
+
+double CampusSpatialIndex::estimateMiles(const QString& a, const QString& b) const {
+    double bound = lowerBoundMiles(a, b);
+    return bound < 0 ? -1 : bound * RoadFactor;
+}
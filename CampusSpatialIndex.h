@@ -0,0 +1,65 @@
+#ifndef CAMPUSSPATIALINDEX_H
+#define CAMPUSSPATIALINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <vector>
+#include <utility>
+#include "DatabaseManager.h"
+
+// k-d tree over campus locations.
+// Campuses are stored as points on the unit sphere so straight-line (chord) distance
+// orders them exactly like great-circle distance, with no special cases at the poles
+// or the date line. Nearest and radius queries visit O(log n) nodes on typical data.
+class CampusSpatialIndex {
+public:
+    // Mean Earth radius in miles.
+    static constexpr double EarthRadiusMiles = 3958.8;
+    // Multiplier from great-circle miles to an estimated driving distance.
+    static constexpr double RoadFactor = 1.2;
+
+    CampusSpatialIndex();
+
+    // Rebuilds the index over the given campuses.
+    void build(const std::vector<CampusCoordinate>& campuses);
+
+    // Returns up to k campuses nearest to a campus as (college, great-circle miles),
+    // closest first, excluding the campus itself.
+    std::vector<std::pair<QString, double>> nearest(const QString& college, int k) const;
+    // Returns every other campus within the given number of miles of a campus, closest first.
+    std::vector<std::pair<QString, double>> withinRadius(const QString& college, double miles) const;
+
+    // Great-circle miles between two campuses. Driving distance is never shorter, so this
+    // is a lower bound for pruning. Returns -1 if either campus has no location.
+    double lowerBoundMiles(const QString& a, const QString& b) const;
+    // Estimated driving miles for a pair with no recorded distance, or -1 if unknown.
+    double estimateMiles(const QString& a, const QString& b) const;
+
+    static double greatCircleMiles(double lat1, double lon1, double lat2, double lon2);
+
+private:
+    struct Point {
+        double xyz[3];
+        int id;
+    };
+
+    // Points in k-d tree order: the node for range [lo, hi) is at (lo + hi) / 2 and
+    // splits on axis depth % 3.
+    std::vector<Point> tree;
+    std::vector<QString> names;
+    std::vector<std::pair<double, double>> locations;
+    QHash<QString, int> ids;
+
+    void buildRange(int lo, int hi, int depth);
+    void searchNearest(int lo, int hi, int depth, const double* target, int k, int exclude,
+                       std::vector<std::pair<double, int>>& heap) const;
+    void searchRadius(int lo, int hi, int depth, const double* target, double chord2, int exclude,
+                      std::vector<std::pair<double, int>>& found) const;
+    std::vector<std::pair<QString, double>> toMiles(std::vector<std::pair<double, int>>& hits) const;
+
+    static void toUnitVector(double latitude, double longitude, double* xyz);
+    static double chordToMiles(double chord);
+    static double milesToChord(double miles);
+};
+
+#endif // CAMPUSSPATIALINDEX_H
@@ -2,12 +2,26 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
+#include <QHash>
+#include <atomic>
+#include <cmath>
 
-DatabaseManager::DatabaseManager(const QString& dbPath) {
-    db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName(dbPath);
+namespace {
+// Small number that identifies the calling thread for its whole lifetime.
+// Unlike QThread::currentThreadId() it is never reused by a later thread.
+int threadSlot() {
+    static std::atomic<int> nextSlot(0);
+    thread_local int slot = ++nextSlot;
+    return slot;
+}
+}
+
+DatabaseManager::DatabaseManager(const QString& dbPath)
+    : path(dbPath),
+      connectionPrefix(QString("campus_%1_").arg(reinterpret_cast<quintptr>(this))) {
+    db = connection();
 
-    if (!db.open()) {
+    if (!db.isOpen()) {
         qDebug() << "Failed to open database:" << db.lastError().text();
     } else {
         initializeTables();
@@ -18,10 +32,58 @@ DatabaseManager::~DatabaseManager() {
     if (db.isOpen()) {
         db.close();
     }
+    db = QSqlDatabase();
+
+    // Worker threads should have released their connections already; drop any leftovers.
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (const QString &name : connectionNames) {
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+QSqlDatabase DatabaseManager::connection() {
+    QString name = connectionPrefix + QString::number(threadSlot());
+    if (QSqlDatabase::contains(name))
+        return QSqlDatabase::database(name);
+
+    QSqlDatabase conn = QSqlDatabase::addDatabase("QSQLITE", name);
+    conn.setDatabaseName(path);
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        connectionNames.insert(name);
+    }
+    if (!conn.open()) {
+        qDebug() << "Failed to open database connection" << name << ":" << conn.lastError().text();
+        return conn;
+    }
+
+    // WAL lets any number of readers work alongside one writer; the busy timeout
+    // makes a second writer wait for the lock instead of failing straight away.
+    QSqlQuery pragma(conn);
+    if (!pragma.exec("PRAGMA journal_mode=WAL"))
+        qDebug() << "Failed to enable WAL:" << pragma.lastError().text();
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    pragma.exec("PRAGMA busy_timeout=5000");
+    return conn;
+}
+
+void DatabaseManager::releaseThreadConnection() {
+    QString name = connectionPrefix + QString::number(threadSlot());
+    {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (connectionNames.erase(name) == 0)
+            return;
+    }
+    {
+        QSqlDatabase conn = QSqlDatabase::database(name, false);
+        if (conn.isOpen())
+            conn.close();
+    }
+    QSqlDatabase::removeDatabase(name);
 }
 
 void DatabaseManager::initializeTables() {
-    QSqlQuery query;
+    QSqlQuery query(connection());
 
     // query.exec("DROP TABLE IF EXISTS Distances");
     // query.exec("DROP TABLE IF EXISTS Souvenirs");
@@ -34,6 +96,31 @@ void DatabaseManager::initializeTables() {
                     "PRIMARY KEY (start_college, end_college))")) {
         qDebug() << "Failed to create Distances table:" << query.lastError().text();
     }
+
+    // Each pair is stored once, as (min(a, b), max(a, b)), and read in both directions.
+    // Older databases kept both directions: report pairs whose two rows disagree,
+    // then fold every pair into its canonical row.
+    if (query.exec("SELECT a.start_college, a.end_college, a.distance, b.distance "
+                   "FROM Distances a JOIN Distances b "
+                   "ON a.start_college = b.end_college AND a.end_college = b.start_college "
+                   "WHERE a.start_college < a.end_college AND a.distance <> b.distance")) {
+        while (query.next()) {
+            addImportIssue(QString("%1 <-> %2: %3 miles one way, %4 the other (kept %3)")
+                               .arg(query.value(0).toString(), query.value(1).toString())
+                               .arg(query.value(2).toDouble())
+                               .arg(query.value(3).toDouble()));
+        }
+    }
+    if (!query.exec("INSERT OR IGNORE INTO Distances (start_college, end_college, distance) "
+                    "SELECT end_college, start_college, distance FROM Distances "
+                    "WHERE start_college > end_college")
+        || !query.exec("DELETE FROM Distances WHERE start_college >= end_college")) {
+        qDebug() << "Failed to fold Distances into canonical pairs:" << query.lastError().text();
+    }
+    // Lookups by end_college serve the mirrored direction.
+    if (!query.exec("CREATE INDEX IF NOT EXISTS DistancesByEnd ON Distances (end_college)")) {
+        qDebug() << "Failed to index Distances:" << query.lastError().text();
+    }
     
     // Create the Souvenirs table with a composite primary key
     if (!query.exec("CREATE TABLE IF NOT EXISTS Souvenirs ("
@@ -43,6 +130,14 @@ void DatabaseManager::initializeTables() {
                     "PRIMARY KEY (college, souvenir))")) {
         qDebug() << "Failed to create Souvenirs table:" << query.lastError().text();
     }
+
+    // Optional campus locations; colleges without a row simply have no coordinates.
+    if (!query.exec("CREATE TABLE IF NOT EXISTS Coordinates ("
+                    "college TEXT PRIMARY KEY, "
+                    "latitude REAL NOT NULL, "
+                    "longitude REAL NOT NULL)")) {
+        qDebug() << "Failed to create Coordinates table:" << query.lastError().text();
+    }
 }
 
 QStringList parseCSVLine(const QString &line) {
@@ -83,7 +178,7 @@ bool DatabaseManager::importCSV(const QString &filePath, const QString &tableNam
     
     QTextStream in(&file);
     
-    QSqlQuery query;
+    QSqlQuery query(connection());
     while (!in.atEnd()) {
         QString line = in.readLine();
         // Use the CSV parser to properly split the line.
@@ -122,9 +217,94 @@ bool DatabaseManager::importCSV(const QString &filePath, const QString &tableNam
     return true;
 }
 
+bool DatabaseManager::importDistances(const QString &filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Failed to open" << filePath;
+        return false;
+    }
+
+    QTextStream in(&file);
+    QSqlDatabase conn = connection();
+    QSqlQuery lookup(conn);
+    QSqlQuery insert(conn);
+    // SQLite's min/max order the names, so the canonical order has one definition.
+    lookup.prepare("SELECT distance FROM Distances WHERE start_college = min(?, ?) AND end_college = max(?, ?)");
+    insert.prepare("INSERT INTO Distances (start_college, end_college, distance) VALUES (min(?, ?), max(?, ?), ?)");
+
+    if (!conn.transaction()) {
+        qDebug() << "importDistances could not start a transaction:" << conn.lastError().text();
+        return false;
+    }
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        QStringList values = parseCSVLine(line);
+        if (values.size() != 3) {
+            qDebug() << "Skipping line due to field count mismatch:" << line;
+            continue;
+        }
+        QString from = values[0].trimmed();
+        QString to = values[1].trimmed();
+        bool ok = false;
+        double distance = values[2].trimmed().toDouble(&ok);
+        if (!ok || from.isEmpty() || to.isEmpty() || from == to) {
+            qDebug() << "Skipping invalid distance row:" << line;
+            continue;
+        }
+
+        // The first distance seen for a pair wins; a different one for either
+        // direction is reported rather than silently dropped.
+        lookup.addBindValue(from);
+        lookup.addBindValue(to);
+        lookup.addBindValue(from);
+        lookup.addBindValue(to);
+        if (lookup.exec() && lookup.next()) {
+            double stored = lookup.value(0).toDouble();
+            lookup.finish();
+            if (std::abs(stored - distance) > 1e-9) {
+                addImportIssue(QString("%1 -> %2: %3 miles, but %4 was already recorded for this pair (kept %4)")
+                                   .arg(from, to)
+                                   .arg(distance)
+                                   .arg(stored));
+            }
+            continue;
+        }
+        lookup.finish();
+
+        insert.addBindValue(from);
+        insert.addBindValue(to);
+        insert.addBindValue(from);
+        insert.addBindValue(to);
+        insert.addBindValue(distance);
+        if (!insert.exec()) {
+            qDebug() << "Insert failed:" << insert.lastError().text();
+        }
+    }
+    file.close();
+    if (!conn.commit()) {
+        qDebug() << "importDistances failed to commit, nothing was imported:" << conn.lastError().text();
+        conn.rollback();
+        return false;
+    }
+    return true;
+}
+
+void DatabaseManager::addImportIssue(const QString& issue) {
+    std::lock_guard<std::mutex> lock(issuesMutex);
+    importIssues << issue;
+}
+
+QStringList DatabaseManager::takeImportIssues() {
+    std::lock_guard<std::mutex> lock(issuesMutex);
+    QStringList issues;
+    issues.swap(importIssues);
+    return issues;
+}
+
 std::vector<QString> DatabaseManager::getColleges() {
     std::vector<QString> colleges;
-    QSqlQuery query("SELECT DISTINCT start_college FROM Distances");
+    // A college may only appear on either side of its canonical pairs.
+    QSqlQuery query("SELECT start_college FROM Distances UNION SELECT end_college FROM Distances", connection());
     while (query.next()) {
         colleges.push_back(query.value(0).toString());
     }
@@ -133,8 +313,11 @@ std::vector<QString> DatabaseManager::getColleges() {
 
 std::vector<std::pair<QString, double>> DatabaseManager::getDistances(const QString& college) {
     std::vector<std::pair<QString, double>> distances;
-    QSqlQuery query;
-    query.prepare("SELECT end_college, distance FROM Distances WHERE start_college = ?");
+    QSqlQuery query(connection());
+    query.prepare("SELECT end_college, distance FROM Distances WHERE start_college = ? "
+                  "UNION ALL "
+                  "SELECT start_college, distance FROM Distances WHERE end_college = ?");
+    query.addBindValue(college);
     query.addBindValue(college);
     if (query.exec()) {
         while (query.next()) {
@@ -146,10 +329,26 @@ std::vector<std::pair<QString, double>> DatabaseManager::getDistances(const QStr
     return distances;
 }
 
+std::vector<DistanceEdge> DatabaseManager::getAllDistances() {
+    std::vector<DistanceEdge> edges;
+    QSqlQuery query(connection());
+    if (query.exec("SELECT start_college, end_college, distance FROM Distances")) {
+        while (query.next()) {
+            edges.push_back(DistanceEdge{query.value(0).toString(),
+                                         query.value(1).toString(),
+                                         query.value(2).toDouble()});
+        }
+    } else {
+        qDebug() << "getAllDistances query failed:" << query.lastError().text();
+    }
+    return edges;
+}
+
 std::vector<std::pair<QString, double>> DatabaseManager::getSouvenirs(const QString& college) {
     std::vector<std::pair<QString, double>> souvenirs;
-    QSqlQuery query;
-    query.prepare("SELECT souvenir, price FROM Souvenirs WHERE college = ?");
+    QSqlQuery query(connection());
+    // Same order as getSouvenirCatalogs, so a stop lists the same way with or without the prefetch.
+    query.prepare("SELECT souvenir, price FROM Souvenirs WHERE college = ? ORDER BY souvenir");
     query.addBindValue(college);
     if (query.exec()) {
         while (query.next()) {
@@ -161,20 +360,71 @@ std::vector<std::pair<QString, double>> DatabaseManager::getSouvenirs(const QStr
     return souvenirs;
 }
 
-bool DatabaseManager::updateSouvenirPrice(const QString& souvenir, double newPrice) {
-    QSqlQuery query;
-    query.prepare("UPDATE Souvenirs SET price = ? WHERE souvenir = ?");
+std::vector<std::vector<std::pair<QString, double>>> DatabaseManager::getSouvenirCatalogs(
+    const std::vector<QString>& colleges) {
+    std::vector<std::vector<std::pair<QString, double>>> catalogs(colleges.size());
+    QHash<QString, std::vector<int>> positions;
+    std::vector<QString> distinct;
+    for (int i = 0; i < static_cast<int>(colleges.size()); i++) {
+        std::vector<int> &at = positions[colleges[i]];
+        if (at.empty())
+            distinct.push_back(colleges[i]);
+        at.push_back(i);
+    }
+
+    // SQLite limits the parameters of one statement, so only very long lists take more than one query.
+    const int maxParameters = 500;
+    QSqlQuery query(connection());
+    for (size_t first = 0; first < distinct.size(); first += maxParameters) {
+        size_t count = std::min(distinct.size() - first, static_cast<size_t>(maxParameters));
+        QStringList placeholders;
+        for (size_t i = 0; i < count; i++)
+            placeholders << "?";
+        query.prepare("SELECT college, souvenir, price FROM Souvenirs WHERE college IN ("
+                      + placeholders.join(", ") + ") ORDER BY college, souvenir");
+        for (size_t i = 0; i < count; i++)
+            query.addBindValue(distinct[first + i]);
+        if (!query.exec()) {
+            qDebug() << "getSouvenirCatalogs query failed:" << query.lastError().text();
+            continue;
+        }
+        while (query.next()) {
+            QString college = query.value(0).toString();
+            std::pair<QString, double> souvenir(query.value(1).toString(), query.value(2).toDouble());
+            for (int position : positions.value(college))
+                catalogs[position].push_back(souvenir);
+        }
+    }
+    return catalogs;
+}
+
+std::vector<QString> DatabaseManager::getSouvenirNames() {
+    std::vector<QString> names;
+    QSqlQuery query(connection());
+    if (query.exec("SELECT souvenir FROM Souvenirs")) {
+        while (query.next())
+            names.push_back(query.value(0).toString());
+    } else {
+        qDebug() << "getSouvenirNames query failed:" << query.lastError().text();
+    }
+    return names;
+}
+
+bool DatabaseManager::updateSouvenirPrice(const QString& college, const QString& souvenir, double newPrice) {
+    QSqlQuery query(connection());
+    query.prepare("UPDATE Souvenirs SET price = ? WHERE college = ? AND souvenir = ?");
     query.addBindValue(newPrice);
+    query.addBindValue(college);
     query.addBindValue(souvenir);
     if (!query.exec()) {
         qDebug() << "updateSouvenirPrice failed:" << query.lastError().text();
         return false;
     }
-    return true;
+    return query.numRowsAffected() > 0;
 }
 
 bool DatabaseManager::addSouvenir(const QString& college, const QString& souvenir, double price) {
-    QSqlQuery query;
+    QSqlQuery query(connection());
     query.prepare("INSERT INTO Souvenirs (college, souvenir, price) VALUES (?, ?, ?)");
     query.addBindValue(college);
     query.addBindValue(souvenir);
@@ -186,21 +436,154 @@ bool DatabaseManager::addSouvenir(const QString& college, const QString& souveni
     return true;
 }
 
-bool DatabaseManager::removeSouvenir(const QString& souvenir) {
-    QSqlQuery query;
-    query.prepare("DELETE FROM Souvenirs WHERE souvenir = ?");
+bool DatabaseManager::removeSouvenir(const QString& college, const QString& souvenir) {
+    QSqlQuery query(connection());
+    query.prepare("DELETE FROM Souvenirs WHERE college = ? AND souvenir = ?");
+    query.addBindValue(college);
     query.addBindValue(souvenir);
     if (!query.exec()) {
         qDebug() << "removeSouvenir failed:" << query.lastError().text();
         return false;
     }
-    return true;
+    return query.numRowsAffected() > 0;
+}
+
+CatalogSyncResult DatabaseManager::syncSouvenirCatalog(const QString& filePath, bool removeMissing,
+                                                       const std::function<bool(const CatalogSyncResult&)>& confirm) {
+    CatalogSyncResult result = {false, 0, 0, 0, 0, 0, QString()};
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Failed to open" << filePath;
+        return result;
+    }
+
+    // Current catalog, keyed by (college, souvenir).
+    typedef std::pair<QString, QString> Key;
+    QHash<Key, double> current;
+    QSqlDatabase conn = connection();
+    QSqlQuery query(conn);
+    if (!query.exec("SELECT college, souvenir, price FROM Souvenirs")) {
+        qDebug() << "syncSouvenirCatalog query failed:" << query.lastError().text();
+        return result;
+    }
+    while (query.next())
+        current.insert(Key(query.value(0).toString(), query.value(1).toString()), query.value(2).toDouble());
+    query.finish();
+
+    // Wanted catalog from the file; a later row for the same souvenir replaces an earlier one.
+    QHash<Key, double> wanted;
+    std::vector<Key> order;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.trimmed().isEmpty())
+            continue;
+        QStringList values = parseCSVLine(line);
+        bool ok = false;
+        double price = values.size() == 3 ? values[2].trimmed().toDouble(&ok) : 0;
+        Key key(values.value(0).trimmed(), values.value(1).trimmed());
+        if (!ok || key.first.isEmpty() || key.second.isEmpty()) {
+            qDebug() << "Skipping invalid catalog row:" << line;
+            result.skipped++;
+            continue;
+        }
+        if (!wanted.contains(key))
+            order.push_back(key);
+        wanted.insert(key, price);
+    }
+    file.close();
+
+    // Anything unlisted would be deleted, so only trust a file that parsed cleanly.
+    if (wanted.isEmpty()) {
+        result.problem = "The file has no valid catalog rows.";
+        return result;
+    }
+    if (removeMissing && result.skipped > 0) {
+        result.problem = QString("%1 line(s) of the file could not be read, so no souvenirs were removed. "
+                                 "Fix the file or sync without removing.").arg(result.skipped);
+        return result;
+    }
+
+    // Diff in memory, then write only the rows that changed.
+    std::vector<std::pair<Key, double>> added, updated;
+    for (const Key &key : order) {
+        double price = wanted.value(key);
+        auto it = current.constFind(key);
+        if (it == current.constEnd())
+            added.emplace_back(key, price);
+        else if (std::abs(it.value() - price) > 1e-9)
+            updated.emplace_back(key, price);
+        else
+            result.unchanged++;
+    }
+    std::vector<Key> removed;
+    if (removeMissing) {
+        for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+            if (!wanted.contains(it.key()))
+                removed.push_back(it.key());
+        }
+    }
+
+    if (confirm) {
+        CatalogSyncResult planned = result;
+        planned.added = static_cast<int>(added.size());
+        planned.updated = static_cast<int>(updated.size());
+        planned.removed = static_cast<int>(removed.size());
+        if (!confirm(planned)) {
+            result.unchanged = 0;
+            result.problem = "The sync was cancelled.";
+            return result;
+        }
+    }
+
+    QSqlQuery insert(conn), update(conn), remove(conn);
+    insert.prepare("INSERT INTO Souvenirs (college, souvenir, price) VALUES (?, ?, ?)");
+    update.prepare("UPDATE Souvenirs SET price = ? WHERE college = ? AND souvenir = ?");
+    remove.prepare("DELETE FROM Souvenirs WHERE college = ? AND souvenir = ?");
+
+    if (!conn.transaction()) {
+        qDebug() << "syncSouvenirCatalog could not start a transaction:" << conn.lastError().text();
+        return result;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < added.size(); i++) {
+        insert.addBindValue(added[i].first.first);
+        insert.addBindValue(added[i].first.second);
+        insert.addBindValue(added[i].second);
+        ok = insert.exec();
+    }
+    for (size_t i = 0; ok && i < updated.size(); i++) {
+        update.addBindValue(updated[i].second);
+        update.addBindValue(updated[i].first.first);
+        update.addBindValue(updated[i].first.second);
+        ok = update.exec();
+    }
+    for (size_t i = 0; ok && i < removed.size(); i++) {
+        remove.addBindValue(removed[i].first);
+        remove.addBindValue(removed[i].second);
+        ok = remove.exec();
+    }
+    if (!ok || !conn.commit()) {
+        qDebug() << "syncSouvenirCatalog failed, nothing was changed:" << conn.lastError().text()
+                 << insert.lastError().text() << update.lastError().text() << remove.lastError().text();
+        conn.rollback();
+        result.unchanged = 0;
+        return result;
+    }
+
+    result.ok = true;
+    result.added = static_cast<int>(added.size());
+    result.updated = static_cast<int>(updated.size());
+    result.removed = static_cast<int>(removed.size());
+    return result;
 }
 
 double DatabaseManager::getDistance(const QString& startCollege, const QString& endCollege) {
     double distance = std::numeric_limits<double>::max();
-    QSqlQuery query;
-    query.prepare("SELECT distance FROM Distances WHERE start_college = ? AND end_college = ?");
+    QSqlQuery query(connection());
+    query.prepare("SELECT distance FROM Distances WHERE start_college = min(?, ?) AND end_college = max(?, ?)");
+    query.addBindValue(startCollege);
+    query.addBindValue(endCollege);
     query.addBindValue(startCollege);
     query.addBindValue(endCollege);
     if(query.exec() && query.next()) {
@@ -212,13 +595,33 @@ double DatabaseManager::getDistance(const QString& startCollege, const QString&
 }
 
 bool DatabaseManager::importNewCampuses(const QString &filePath) {
-    QStringList columns = {"start_college", "end_college", "distance"};
-    return importCSV(filePath, "Distances", columns);
+    return importDistances(filePath);
+}
+
+bool DatabaseManager::importCoordinates(const QString &filePath) {
+    QStringList columns = {"college", "latitude", "longitude"};
+    return importCSV(filePath, "Coordinates", columns);
+}
+
+std::vector<CampusCoordinate> DatabaseManager::getCoordinates() {
+    std::vector<CampusCoordinate> coordinates;
+    QSqlQuery query(connection());
+    if (query.exec("SELECT college, latitude, longitude FROM Coordinates")) {
+        while (query.next()) {
+            coordinates.push_back(CampusCoordinate{query.value(0).toString(),
+                                                   query.value(1).toDouble(),
+                                                   query.value(2).toDouble()});
+        }
+    } else {
+        qDebug() << "getCoordinates query failed:" << query.lastError().text();
+    }
+    return coordinates;
 }
 
 void DatabaseManager::dropTables() {
-    QSqlQuery query;
+    QSqlQuery query(connection());
     
     query.exec("DROP TABLE IF EXISTS Distances");
     query.exec("DROP TABLE IF EXISTS Souvenirs");
+    query.exec("DROP TABLE IF EXISTS Coordinates");
 }
\ No newline at end of file
@@ -13,6 +13,35 @@
 #include <QStringList>
 #include <limits>
 #include <algorithm>
+#include <mutex>
+#include <set>
+#include <functional>
+
+// Location of a campus in decimal degrees.
+struct CampusCoordinate {
+    QString college;
+    double latitude;
+    double longitude;
+};
+
+// One row of the Distances table. Each pair of colleges is stored once and the
+// distance applies in both directions.
+struct DistanceEdge {
+    QString startCollege;
+    QString endCollege;
+    double distance;
+};
+
+// Outcome of DatabaseManager::syncSouvenirCatalog.
+struct CatalogSyncResult {
+    bool ok;        // False if the file could not be read or the transaction failed (nothing changed).
+    int added;
+    int updated;    // Price changed.
+    int removed;
+    int unchanged;
+    int skipped;    // Malformed lines in the file.
+    QString problem; // Why nothing was changed, when the file was read but the sync was refused or cancelled.
+};
 
 class DatabaseManager {
 public:
@@ -22,38 +51,90 @@ public:
     // Destructor: closes the database connection if open
     ~DatabaseManager();
 
+    // Returns the calling thread's connection, opening it (in WAL mode) on first use.
+    // Every query goes through this, so any thread may call any method.
+    QSqlDatabase connection();
+
+    // Closes the calling thread's connection; worker threads call this before they exit.
+    void releaseThreadConnection();
+
     // Returns a list of unique college names from both tables
     std::vector<QString> getColleges();
 
-    // Given a college name, returns a list of (end_college, distance) pairs
+    // Given a college name, returns a list of (other college, distance) pairs, whichever
+    // side of the stored pair the college is on
     std::vector<std::pair<QString, double>> getDistances(const QString& college);
 
-    // Given a college name, returns a list of (souvenir, price) pairs
+    // Returns every row of the Distances table (one per pair) in one query
+    std::vector<DistanceEdge> getAllDistances();
+
+    // Given a college name, returns a list of (souvenir, price) pairs sorted by souvenir
     std::vector<std::pair<QString, double>> getSouvenirs(const QString& college);
 
-    // Update the price of a souvenir; returns true if successful
-    bool updateSouvenirPrice(const QString& souvenir, double newPrice);
+    // Returns the (souvenir, price) pairs of every college in the list with one batched
+    // query; element i of the result belongs to colleges[i], sorted like getSouvenirs.
+    std::vector<std::vector<std::pair<QString, double>>> getSouvenirCatalogs(const std::vector<QString>& colleges);
+
+    // Returns the souvenir name of every row in the Souvenirs table (one per college selling it)
+    std::vector<QString> getSouvenirNames();
+
+    // Update the price of a souvenir at one college; returns true if it was found and updated
+    bool updateSouvenirPrice(const QString& college, const QString& souvenir, double newPrice);
 
     // Adds a new souvenir for a given college; returns true if successful
     bool addSouvenir(const QString& college, const QString& souvenir, double price);
 
-    // Removes a souvenir by name; returns true if successful
-    bool removeSouvenir(const QString& souvenir);
+    // Removes a souvenir from one college; returns true if it was found and removed
+    bool removeSouvenir(const QString& college, const QString& souvenir);
+
+    // Brings the Souvenirs table in line with a college,souvenir,price CSV file. The file
+    // is diffed against the table in memory, keyed by (college, souvenir), and only the
+    // added, repriced and (if removeMissing) unlisted rows are written, in one transaction.
+    // Removing is refused if the file has no valid rows or any malformed ones, since the
+    // wrong or a damaged file would otherwise empty the table. If confirm is given it is
+    // called with the planned counts before anything is written; returning false cancels.
+    CatalogSyncResult syncSouvenirCatalog(const QString& filePath, bool removeMissing,
+                                          const std::function<bool(const CatalogSyncResult&)>& confirm = nullptr);
 
     // Initial import from csv files 
     bool importCSV(const QString& filePath, const QString& tableName, const QStringList& columns);
 
-    // Given a reference college and an ending college, return the distance.
+    // Given a reference college and an ending college, return the distance (the same both ways).
     double getDistance(const QString& startCollege, const QString& endCollege);
 
+    // Imports a start,end,distance CSV file into the Distances table, storing each
+    // pair once. Rows that disagree with a distance already recorded for the pair
+    // (in either direction) are skipped and reported through takeImportIssues().
+    bool importDistances(const QString& filePath);
+
     // Import new campuses CSV file into the Distances table.
     bool importNewCampuses(const QString& filePath);
 
+    // Returns the validation issues found by imports since the last call, and forgets them.
+    QStringList takeImportIssues();
+
+    // Import a college,latitude,longitude CSV file into the Coordinates table.
+    bool importCoordinates(const QString& filePath);
+
+    // Returns every campus that has a known location.
+    std::vector<CampusCoordinate> getCoordinates();
+
     // Drops tables for a fresh db 
     void dropTables();
 
 private:
+    QString path;
+    // Connection names are this prefix plus a per-thread number.
+    QString connectionPrefix;
+    // Connection of the thread that created the manager (the GUI thread).
     QSqlDatabase db;
+    std::mutex connectionMutex;
+    std::set<QString> connectionNames;
+    // Validation issues not yet collected with takeImportIssues(), guarded by issuesMutex
+    // since imports may run on any thread.
+    QStringList importIssues;
+    std::mutex issuesMutex;
+    void addImportIssue(const QString& issue);
     void initializeTables();
 };
 
@@ -0,0 +1,142 @@
+#include "DistanceGraph.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+DistanceGraph::DistanceGraph() : graphVersion(0), offsets(1, 0) { }
+
+size_t DistanceGraph::slot(int a, int b) {
+    if (a > b)
+        std::swap(a, b);
+    return static_cast<size_t>(b) * (b - 1) / 2 + a;
+}
+
+int DistanceGraph::intern(const QString& college) {
+    auto it = ids.constFind(college);
+    if (it != ids.constEnd())
+        return it.value();
+    int id = static_cast<int>(names.size());
+    names.push_back(college);
+    ids.insert(college, id);
+    // Column `id` of the triangle goes right after the earlier ones.
+    packed.resize(static_cast<size_t>(id + 1) * id / 2, std::numeric_limits<double>::infinity());
+    return id;
+}
+
+void DistanceGraph::build(const std::vector<DistanceEdge>& edges, const std::vector<CampusCoordinate>& coordinates) {
+    names.clear();
+    ids.clear();
+    packed.clear();
+    locations.build(coordinates);
+
+    std::vector<std::pair<int, int>> pairs;
+    pairs.reserve(edges.size());
+    for (const DistanceEdge& e : edges) {
+        int from = intern(e.startCollege);
+        int to = intern(e.endCollege);
+        if (from == to)
+            continue;
+        double& d = packed[slot(from, to)];
+        if (d == std::numeric_limits<double>::infinity()) {
+            d = e.distance;
+            pairs.emplace_back(from, to);
+        }
+    }
+
+    // Neighbour lists in both directions, bucketed by college.
+    int n = size();
+    offsets.assign(n + 1, 0);
+    for (const auto& p : pairs) {
+        offsets[p.first + 1]++;
+        offsets[p.second + 1]++;
+    }
+    for (int i = 0; i < n; i++)
+        offsets[i + 1] += offsets[i];
+    neighbours.assign(pairs.size() * 2, 0);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& p : pairs) {
+        neighbours[fill[p.first]++] = p.second;
+        neighbours[fill[p.second]++] = p.first;
+    }
+}
+
+quint64 DistanceGraph::version() const {
+    return graphVersion;
+}
+
+int DistanceGraph::size() const {
+    return static_cast<int>(names.size());
+}
+
+int DistanceGraph::idOf(const QString& college) const {
+    return ids.value(college, -1);
+}
+
+const QString& DistanceGraph::name(int id) const {
+    return names[id];
+}
+
+double DistanceGraph::distance(int from, int to) const {
+    if (from == to)
+        return 0;
+    return packed[slot(from, to)];
+}
+
+const CampusSpatialIndex& DistanceGraph::spatialIndex() const {
+    return locations;
+}
+
+std::vector<int> DistanceGraph::nearestReachable(int start, int count) const {
+    std::vector<int> result;
+    int n = size();
+    if (start < 0 || start >= n || count <= 0)
+        return result;
+
+    std::vector<double> best(n, std::numeric_limits<double>::infinity());
+    std::vector<bool> settled(n, false);
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+    best[start] = 0;
+    heap.emplace(0.0, start);
+    while (!heap.empty() && static_cast<int>(result.size()) < count) {
+        Entry top = heap.top();
+        heap.pop();
+        int u = top.second;
+        if (settled[u])
+            continue;
+        settled[u] = true;
+        if (u != start)
+            result.push_back(u);
+
+        for (int k = offsets[u]; k < offsets[u + 1]; k++) {
+            int v = neighbours[k];
+            double d = top.first + packed[slot(u, v)];
+            if (!settled[v] && d < best[v]) {
+                best[v] = d;
+                heap.emplace(d, v);
+            }
+        }
+    }
+    return result;
+}
+
+DistanceGraphStore::DistanceGraphStore()
+    : snapshot(std::make_shared<const DistanceGraph>()), lastVersion(0) { }
+
+std::shared_ptr<const DistanceGraph> DistanceGraphStore::current() const {
+    return std::atomic_load(&snapshot);
+}
+
+quint64 DistanceGraphStore::publish(DistanceGraph&& next) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::shared_ptr<DistanceGraph> graph = std::make_shared<DistanceGraph>(std::move(next));
+    graph->graphVersion = ++lastVersion;
+    std::atomic_store(&snapshot, std::shared_ptr<const DistanceGraph>(std::move(graph)));
+    return lastVersion;
+}
+
+quint64 DistanceGraphStore::version() const {
+    return current()->version();
+}
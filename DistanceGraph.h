@@ -0,0 +1,91 @@
+#ifndef DISTANCEGRAPH_H
+#define DISTANCEGRAPH_H
+
+#include <QString>
+#include <QHash>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include "DatabaseManager.h"
+#include "CampusSpatialIndex.h"
+
+// In-memory copy of the Distances table.
+// Colleges are numbered 0..size()-1 and distances are symmetric, so only the pairs
+// (a, b) with a < b are stored, packed column by column into one upper-triangular
+// array: pair (a, b) lives at b * (b - 1) / 2 + a. A lookup in either direction is
+// one index calculation, with no second copy of each distance to keep in sync.
+// The graph also carries the campus locations read with it, so a snapshot gives the
+// planner distances and coordinate estimates from the same version of the data.
+class DistanceGraph {
+public:
+    DistanceGraph();
+
+    // Rebuilds the graph from a list of edges, each used in both directions, and the
+    // known campus locations. If a pair appears more than once, the first distance
+    // given for it is kept.
+    void build(const std::vector<DistanceEdge>& edges, const std::vector<CampusCoordinate>& coordinates);
+
+    // Version assigned when the graph was published through a DistanceGraphStore (0 if never).
+    quint64 version() const;
+    int size() const;
+    // Returns the id of a college, or -1 if it is not in the graph.
+    int idOf(const QString& college) const;
+    const QString& name(int id) const;
+
+    // Direct distance between two colleges (the same both ways), or infinity if there is no edge.
+    double distance(int from, int to) const;
+    // Locations of the campuses, for bounds and estimates of missing distances.
+    const CampusSpatialIndex& spatialIndex() const;
+
+    // Runs Dijkstra from the start college and returns the ids of the `count`
+    // closest reachable colleges (by shortest driving distance), closest first.
+    // The search stops as soon as that many colleges have been settled, so with a
+    // heap and per-college neighbour lists it only touches the part of the graph
+    // near the start.
+    std::vector<int> nearestReachable(int start, int count) const;
+
+private:
+    friend class DistanceGraphStore;
+
+    quint64 graphVersion;
+    std::vector<QString> names;
+    QHash<QString, int> ids;
+    // Upper triangle of the distance matrix; infinity where no distance is known.
+    std::vector<double> packed;
+    // Colleges with a known distance to college i are neighbours[offsets[i] .. offsets[i + 1]).
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+    CampusSpatialIndex locations;
+
+    int intern(const QString& college);
+    // Position of the pair in packed; requires a != b.
+    static size_t slot(int a, int b);
+};
+
+// Publishes immutable DistanceGraph snapshots to concurrent readers.
+// Readers grab the current snapshot with one atomic shared_ptr load and plan
+// against it for as long as they like; a writer builds the next graph on the
+// side and swaps it in atomically. Old snapshots are freed when their last
+// reader lets go. The atomic shared_ptr operations are not lock-free in common
+// standard libraries (libstdc++ guards them with a small pool of mutexes), so a
+// reader may wait briefly, but only for another pointer copy or swap, never for a
+// graph being built. Writers serialize with each other on writerMutex.
+class DistanceGraphStore {
+public:
+    DistanceGraphStore();
+
+    // Returns the latest published graph (never null; empty before the first publish).
+    std::shared_ptr<const DistanceGraph> current() const;
+    // Stamps the graph with the next version number and makes it current; returns the version.
+    quint64 publish(DistanceGraph&& next);
+    // Version of the current snapshot, for checking whether cached results are stale.
+    quint64 version() const;
+
+private:
+    std::shared_ptr<const DistanceGraph> snapshot;
+    quint64 lastVersion;
+    std::mutex writerMutex;
+};
+
+#endif // DISTANCEGRAPH_H
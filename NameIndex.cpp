@@ -0,0 +1,232 @@
+#include "NameIndex.h"
+#include <algorithm>
+
+NameIndex::NameIndex() { }
+
+std::vector<int> NameIndex::findWordStarts(const QString& folded) {
+    std::vector<int> result;
+    for (int i = 0; i < folded.size(); i++) {
+        if (folded.at(i).isLetterOrNumber() && (i == 0 || !folded.at(i - 1).isLetterOrNumber()))
+            result.push_back(i);
+    }
+    // Names with no letters or digits are still found by their full text.
+    if (result.empty() || result.front() != 0)
+        result.insert(result.begin(), 0);
+    return result;
+}
+
+QStringList NameIndex::splitWords(const QString& folded) {
+    QStringList result;
+    int start = -1;
+    for (int i = 0; i <= folded.size(); i++) {
+        bool inWord = i < folded.size() && folded.at(i).isLetterOrNumber();
+        if (inWord && start < 0)
+            start = i;
+        else if (!inWord && start >= 0) {
+            result << folded.mid(start, i - start);
+            start = -1;
+        }
+    }
+    return result;
+}
+
+QStringView NameIndex::suffix(const Key& key) const {
+    return QStringView(entries[key.entry].folded).mid(key.offset);
+}
+
+bool NameIndex::keyLess(const Key& a, const Key& b) const {
+    int c = suffix(a).compare(suffix(b));
+    return c < 0 || (c == 0 && a.entry < b.entry);
+}
+
+void NameIndex::addKey(std::vector<Key>& keys, const Key& key) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key,
+                               [this](const Key& a, const Key& b) { return keyLess(a, b); });
+    keys.insert(it, key);
+}
+
+void NameIndex::removeKey(std::vector<Key>& keys, const Key& key) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key,
+                               [this](const Key& a, const Key& b) { return keyLess(a, b); });
+    if (it != keys.end() && it->entry == key.entry && it->offset == key.offset)
+        keys.erase(it);
+}
+
+int NameIndex::addEntry(const QString& name) {
+    int id;
+    if (!freeSlots.empty()) {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        id = static_cast<int>(entries.size());
+        entries.emplace_back();
+    }
+    Entry& entry = entries[id];
+    entry.name = name;
+    entry.folded = name.toCaseFolded();
+    entry.wordStarts = findWordStarts(entry.folded);
+    entry.refs = 1;
+    ids.insert(name, id);
+    return id;
+}
+
+void NameIndex::insert(const QString& name) {
+    auto found = ids.constFind(name);
+    if (found != ids.constEnd()) {
+        entries[found.value()].refs++;
+        return;
+    }
+
+    int id = addEntry(name);
+    const Entry& entry = entries[id];
+    addKey(starts, Key{id, 0});
+    for (size_t w = 1; w < entry.wordStarts.size(); w++)
+        addKey(words, Key{id, entry.wordStarts[w]});
+}
+
+void NameIndex::unindex(int id) {
+    Entry& entry = entries[id];
+    // Keys are ordered by the folded text, so remove them before clearing it.
+    removeKey(starts, Key{id, 0});
+    for (size_t w = 1; w < entry.wordStarts.size(); w++)
+        removeKey(words, Key{id, entry.wordStarts[w]});
+    releaseEntry(id);
+}
+
+void NameIndex::releaseEntry(int id) {
+    Entry& entry = entries[id];
+    ids.remove(entry.name);
+    entry.name.clear();
+    entry.folded.clear();
+    entry.wordStarts.clear();
+    entry.refs = 0;
+    freeSlots.push_back(id);
+}
+
+void NameIndex::remove(const QString& name) {
+    auto found = ids.constFind(name);
+    if (found == ids.constEnd())
+        return;
+    int id = found.value();
+    if (--entries[id].refs == 0)
+        unindex(id);
+}
+
+void NameIndex::assign(const std::vector<QString>& names) {
+    QHash<QString, int> counts;
+    for (const QString& name : names)
+        counts[name]++;
+
+    // Adjust the names already indexed and drop the ones that are gone. Keys of
+    // dropped names are filtered out in one pass rather than erased one by one.
+    std::vector<bool> dropped(entries.size(), false);
+    bool anyDropped = false;
+    for (int id = 0; id < static_cast<int>(entries.size()); id++) {
+        if (entries[id].refs == 0)
+            continue;
+        int count = counts.value(entries[id].name, 0);
+        if (count == 0) {
+            dropped[id] = true;
+            anyDropped = true;
+        } else {
+            entries[id].refs = count;
+        }
+    }
+    if (anyDropped) {
+        auto isDropped = [&dropped](const Key& key) { return dropped[key.entry]; };
+        starts.erase(std::remove_if(starts.begin(), starts.end(), isDropped), starts.end());
+        words.erase(std::remove_if(words.begin(), words.end(), isDropped), words.end());
+        for (int id = 0; id < static_cast<int>(dropped.size()); id++) {
+            if (dropped[id])
+                releaseEntry(id);
+        }
+    }
+
+    // Append the keys of new names, sort just those, and merge them in.
+    size_t oldStarts = starts.size(), oldWords = words.size();
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        if (ids.contains(it.key()))
+            continue;
+        int id = addEntry(it.key());
+        entries[id].refs = it.value();
+        starts.push_back(Key{id, 0});
+        for (size_t w = 1; w < entries[id].wordStarts.size(); w++)
+            words.push_back(Key{id, entries[id].wordStarts[w]});
+    }
+    mergeTail(starts, oldStarts);
+    mergeTail(words, oldWords);
+}
+
+void NameIndex::mergeTail(std::vector<Key>& keys, size_t sortedCount) {
+    auto less = [this](const Key& a, const Key& b) { return keyLess(a, b); };
+    std::sort(keys.begin() + sortedCount, keys.end(), less);
+    std::inplace_merge(keys.begin(), keys.begin() + sortedCount, keys.end(), less);
+}
+
+void NameIndex::clear() {
+    entries.clear();
+    freeSlots.clear();
+    ids.clear();
+    starts.clear();
+    words.clear();
+}
+
+void NameIndex::collect(const std::vector<Key>& keys, QStringView prefix, const QStringList& queryWords,
+                        int limit, std::vector<int>& found) const {
+    auto it = std::lower_bound(keys.begin(), keys.end(), prefix,
+                               [this](const Key& key, QStringView p) { return suffix(key).compare(p) < 0; });
+    for (; it != keys.end() && static_cast<int>(found.size()) < limit; ++it) {
+        if (!suffix(*it).startsWith(prefix))
+            break;
+        if (std::find(found.begin(), found.end(), it->entry) != found.end())
+            continue;
+
+        // Every other word of the query has to start some word of the name.
+        const Entry& entry = entries[it->entry];
+        QStringView folded(entry.folded);
+        bool matches = true;
+        for (const QString& word : queryWords) {
+            bool wordFound = false;
+            for (int start : entry.wordStarts) {
+                if (folded.mid(start).startsWith(word)) {
+                    wordFound = true;
+                    break;
+                }
+            }
+            if (!wordFound) {
+                matches = false;
+                break;
+            }
+        }
+        if (matches)
+            found.push_back(it->entry);
+    }
+}
+
+QStringList NameIndex::search(const QString& query, int limit) const {
+    QStringList result;
+    if (limit <= 0)
+        return result;
+
+    std::vector<int> found;
+    QString folded = query.trimmed().toCaseFolded();
+    // Names that start with the query as typed.
+    collect(starts, folded, QStringList(), limit, found);
+
+    // Then word matches, looked up by the longest query word (the fewest keys to walk).
+    QStringList queryWords = splitWords(folded);
+    if (!queryWords.isEmpty() && static_cast<int>(found.size()) < limit) {
+        int lead = 0;
+        for (int i = 1; i < queryWords.size(); i++) {
+            if (queryWords[i].size() > queryWords[lead].size())
+                lead = i;
+        }
+        QString leadWord = queryWords.takeAt(lead);
+        collect(starts, leadWord, queryWords, limit, found);
+        collect(words, leadWord, queryWords, limit, found);
+    }
+
+    for (int id : found)
+        result << entries[id].name;
+    return result;
+}
@@ -0,0 +1,78 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <vector>
+
+// In-memory prefix index over a set of names (campuses or souvenirs) for type-ahead.
+// Every word of every name is a key into a sorted array of case-folded suffixes, so a
+// prefix lookup is a binary search followed by a walk over the matches. Names starting
+// with the query come first; after them come names where each word of the query
+// starts some word of the name, in any order ("wisc mad" finds
+// "University of Wisconsin-Madison"). Names are reference counted, so a souvenir
+// sold at several colleges stays in the index until its last copy is removed.
+class NameIndex {
+public:
+    // Number of results search() returns unless told otherwise.
+    static const int DefaultLimit = 20;
+
+    NameIndex();
+
+    // Adds one reference to a name, indexing it if it is new.
+    void insert(const QString& name);
+    // Drops one reference to a name and unindexes it when none are left.
+    void remove(const QString& name);
+    // Makes the index hold exactly the given names (duplicates add references),
+    // inserting and removing only what changed.
+    void assign(const std::vector<QString>& names);
+    void clear();
+
+    // Case-insensitive type-ahead lookup; returns at most limit names.
+    QStringList search(const QString& query, int limit = DefaultLimit) const;
+
+private:
+    struct Entry {
+        QString name;
+        QString folded;
+        // Offsets in folded where each word starts.
+        std::vector<int> wordStarts;
+        int refs;
+    };
+    // A suffix of entries[entry].folded starting at a word.
+    struct Key {
+        int entry;
+        int offset;
+    };
+
+    // Slots for names; a slot with refs == 0 is free and listed in freeSlots.
+    std::vector<Entry> entries;
+    std::vector<int> freeSlots;
+    QHash<QString, int> ids;
+    // Keys for whole names (offset 0) and for every later word, each sorted by suffix then entry.
+    std::vector<Key> starts;
+    std::vector<Key> words;
+
+    QStringView suffix(const Key& key) const;
+    bool keyLess(const Key& a, const Key& b) const;
+    void addKey(std::vector<Key>& keys, const Key& key);
+    void removeKey(std::vector<Key>& keys, const Key& key);
+    // Fills a slot for a new name without indexing its keys.
+    int addEntry(const QString& name);
+    // Frees the slot of a name whose keys are already gone.
+    void releaseEntry(int id);
+    void unindex(int id);
+    // Sorts keys[sortedCount..] and merges them into the sorted front.
+    void mergeTail(std::vector<Key>& keys, size_t sortedCount);
+    // Appends entries from keys whose suffix starts with prefix and that pass the
+    // word filter, skipping ones already in found, until found holds limit entries.
+    void collect(const std::vector<Key>& keys, QStringView prefix, const QStringList& queryWords,
+                 int limit, std::vector<int>& found) const;
+
+    static std::vector<int> findWordStarts(const QString& folded);
+    static QStringList splitWords(const QString& folded);
+};
+
+#endif // NAMEINDEX_H
@@ -0,0 +1,61 @@
+#include "PlannerWorkspace.h"
+#include <algorithm>
+
+namespace {
+// Every allocation is aligned for any fundamental type.
+const size_t Alignment = alignof(std::max_align_t);
+// Smallest block the arena allocates; enough for a 15-college cost matrix and more.
+const size_t MinBlockSize = 64 * 1024;
+
+size_t alignUp(size_t bytes) {
+    return (bytes + Alignment - 1) & ~(Alignment - 1);
+}
+}
+
+PlannerWorkspace::PlannerWorkspace()
+    : blockSize(0), used(0), planBytes(0), allocations(0) { }
+
+void PlannerWorkspace::reset() {
+    if (!retired.empty()) {
+        // The last plan overflowed into several blocks; replace them with one
+        // block that fits it, so the next plan of that size needs no growth.
+        retired.clear();
+        block.reset();
+        blockSize = 0;
+        grow(planBytes);
+    }
+    used = 0;
+    planBytes = 0;
+}
+
+void PlannerWorkspace::grow(size_t size) {
+    size = std::max(alignUp(size), std::max(MinBlockSize, blockSize * 2));
+    block.reset(new unsigned char[size]);
+    blockSize = size;
+    used = 0;
+    allocations++;
+}
+
+void* PlannerWorkspace::allocateBytes(size_t bytes) {
+    bytes = alignUp(std::max<size_t>(bytes, 1));
+    planBytes += bytes;
+    if (used + bytes > blockSize) {
+        // Earlier allocations of this plan still point into the current block,
+        // so keep it alive until the next reset.
+        if (block)
+            retired.push_back(std::move(block));
+        grow(bytes);
+    }
+    void* p = block.get() + used;
+    used += bytes;
+    return p;
+}
+
+quint64 PlannerWorkspace::allocationCount() const {
+    return allocations;
+}
+
+PlannerWorkspace& PlannerWorkspace::forCurrentThread() {
+    thread_local PlannerWorkspace workspace;
+    return workspace;
+}
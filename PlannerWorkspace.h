@@ -0,0 +1,53 @@
+#ifndef PLANNERWORKSPACE_H
+#define PLANNERWORKSPACE_H
+
+#include <QtGlobal>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Scratch memory for TripPlanner.
+// A workspace owns one growable arena. Each plan resets it and takes its cost
+// matrix and DP tables from the arena with a bump pointer, so once the arena has
+// grown to fit the largest trip seen, planning allocates nothing. A workspace must
+// only be used by one thread at a time; forCurrentThread() gives each thread its own.
+class PlannerWorkspace {
+public:
+    PlannerWorkspace();
+
+    // Starts a new plan. Everything handed out since the last reset is released,
+    // and if the arena had to grow mid-plan it is replaced by one block big enough
+    // for the whole plan.
+    void reset();
+    // Returns uninitialised space for count objects of a trivially copyable type,
+    // valid until the next reset().
+    template <typename T>
+    T* allocate(size_t count);
+
+    // Number of heap blocks the arena has allocated over its lifetime.
+    quint64 allocationCount() const;
+
+    // Workspace private to the calling thread, created on first use.
+    static PlannerWorkspace& forCurrentThread();
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t blockSize;
+    // Offset of the next free byte in block.
+    size_t used;
+    // Bytes requested since the last reset, across every block.
+    size_t planBytes;
+    // Blocks outgrown during the current plan, freed at the next reset.
+    std::vector<std::unique_ptr<unsigned char[]>> retired;
+    quint64 allocations;
+
+    void* allocateBytes(size_t bytes);
+    void grow(size_t size);
+};
+
+template <typename T>
+T* PlannerWorkspace::allocate(size_t count) {
+    return static_cast<T*>(allocateBytes(count * sizeof(T)));
+}
+
+#endif // PLANNERWORKSPACE_H
@@ -0,0 +1,116 @@
+#include "PurchaseLedger.h"
+
+PurchaseLedger::PurchaseLedger(QObject *parent)
+    : QAbstractItemModel(parent), runningTotal(0.0) { }
+
+int PurchaseLedger::groupFor(const QString &college) {
+    auto it = groupIndex.constFind(college);
+    if (it != groupIndex.constEnd())
+        return it.value();
+
+    // New groups go right before the grand total row.
+    int row = static_cast<int>(groups.size());
+    beginInsertRows(QModelIndex(), row, row);
+    groups.push_back(CollegeGroup{college, 0.0, {}});
+    groupIndex.insert(college, row);
+    endInsertRows();
+    return row;
+}
+
+void PurchaseLedger::addCollege(const QString &college) {
+    groupFor(college);
+}
+
+void PurchaseLedger::addPurchase(const PurchasedSouvenir &purchase) {
+    int g = groupFor(purchase.college);
+    CollegeGroup &group = groups[g];
+
+    // Append the purchase under its college.
+    QModelIndex groupRow = createIndex(g, 0, quintptr(0));
+    int row = static_cast<int>(group.purchases.size());
+    beginInsertRows(groupRow, row, row);
+    group.purchases.push_back(purchase);
+    endInsertRows();
+
+    // Only the college total and the grand total change.
+    double cost = purchase.price * purchase.quantity;
+    group.total += cost;
+    runningTotal += cost;
+    emit dataChanged(groupRow, groupRow, {Qt::DisplayRole});
+    QModelIndex totalRow = createIndex(static_cast<int>(groups.size()), 0, quintptr(0));
+    emit dataChanged(totalRow, totalRow, {Qt::DisplayRole});
+}
+
+void PurchaseLedger::clear() {
+    beginResetModel();
+    groups.clear();
+    groupIndex.clear();
+    runningTotal = 0.0;
+    endResetModel();
+}
+
+double PurchaseLedger::collegeTotal(const QString &college) const {
+    auto it = groupIndex.constFind(college);
+    return it == groupIndex.constEnd() ? 0.0 : groups[it.value()].total;
+}
+
+double PurchaseLedger::grandTotal() const {
+    return runningTotal;
+}
+
+QModelIndex PurchaseLedger::index(int row, int column, const QModelIndex &parent) const {
+    if (column != 0 || row < 0)
+        return QModelIndex();
+
+    if (!parent.isValid()) {
+        // College rows plus the grand total row.
+        if (row > static_cast<int>(groups.size()))
+            return QModelIndex();
+        return createIndex(row, 0, quintptr(0));
+    }
+
+    // Children are only found under college rows; remember the group in the internal id.
+    if (parent.internalId() != 0 || parent.row() >= static_cast<int>(groups.size()))
+        return QModelIndex();
+    if (row >= static_cast<int>(groups[parent.row()].purchases.size()))
+        return QModelIndex();
+    return createIndex(row, 0, quintptr(parent.row() + 1));
+}
+
+QModelIndex PurchaseLedger::parent(const QModelIndex &child) const {
+    if (!child.isValid() || child.internalId() == 0)
+        return QModelIndex();
+    return createIndex(static_cast<int>(child.internalId() - 1), 0, quintptr(0));
+}
+
+int PurchaseLedger::rowCount(const QModelIndex &parent) const {
+    if (!parent.isValid())
+        return static_cast<int>(groups.size()) + 1;
+    if (parent.internalId() != 0 || parent.row() >= static_cast<int>(groups.size()))
+        return 0;
+    return static_cast<int>(groups[parent.row()].purchases.size());
+}
+
+int PurchaseLedger::columnCount(const QModelIndex &) const {
+    return 1;
+}
+
+QVariant PurchaseLedger::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+
+    if (index.internalId() != 0) {
+        const PurchasedSouvenir &ps = groups[index.internalId() - 1].purchases[index.row()];
+        return QString("%1: %2 x %3 = $%4")
+            .arg(ps.college)
+            .arg(ps.souvenirName)
+            .arg(ps.quantity)
+            .arg(ps.price * ps.quantity, 0, 'f', 2);
+    }
+
+    if (index.row() == static_cast<int>(groups.size()))
+        return QString("Grand Total: $%1").arg(runningTotal, 0, 'f', 2);
+
+    const CollegeGroup &group = groups[index.row()];
+    return QString("Total for %1: $%2").arg(group.college).arg(group.total, 0, 'f', 2);
+}
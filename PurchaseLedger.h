@@ -0,0 +1,60 @@
+#ifndef PURCHASELEDGER_H
+#define PURCHASELEDGER_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QString>
+#include <vector>
+
+struct PurchasedSouvenir {
+    QString college;
+    QString souvenirName;
+    double price;
+    int quantity;
+};
+
+// Tree model of every souvenir bought on the trip.
+// Top level rows are one "Total for <college>" row per college (in the order they
+// were first seen) followed by a single "Grand Total" row. Each college row has its
+// purchases as children. Totals are kept as running sums, so recording a purchase
+// only inserts one child row and refreshes the two affected total rows.
+class PurchaseLedger : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    explicit PurchaseLedger(QObject *parent = nullptr);
+
+    // Records a purchase and updates the college and grand totals.
+    void addPurchase(const PurchasedSouvenir &purchase);
+    // Adds an (initially empty) group for a college so it shows up with a $0.00 total.
+    void addCollege(const QString &college);
+    // Removes every purchase and college group.
+    void clear();
+
+    double collegeTotal(const QString &college) const;
+    double grandTotal() const;
+
+    // QAbstractItemModel interface
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct CollegeGroup {
+        QString college;
+        double total;
+        std::vector<PurchasedSouvenir> purchases;
+    };
+
+    // Groups in display order; groupIndex maps a college name to its position.
+    std::vector<CollegeGroup> groups;
+    QHash<QString, int> groupIndex;
+    double runningTotal;
+
+    // Returns the group for a college, appending a new one if needed.
+    int groupFor(const QString &college);
+};
+
+#endif // PURCHASELEDGER_H
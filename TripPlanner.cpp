@@ -1,93 +1,576 @@
 #include "TripPlanner.h"
-#include "DatabaseManager.h"
+#include "CampusSpatialIndex.h"
+#include "DistanceGraph.h"
+#include "PlannerWorkspace.h"
+#include <algorithm>
 #include <limits>
+#include <type_traits>
 
-TripPlanner::TripPlanner() : totalCost(0), n(0) { }
+TripPlanner::TripPlanner()
+    : totalCost(0), totalScore(0), n(0), graphVersion(0), spatialIndex(nullptr),
+      scratch(nullptr), allocations(0), capacityMark(),
+      exactSolve(false), approximation(Exact), roundTripEnd(0), roundTripCost(0), roundTripReturn(0) { }
 
-double TripPlanner::tspHelper(int mask, int curr, const std::vector<std::vector<double>> &cost) {
-    // Base case: when all colleges have been visited, do not add the return cost.
-    if (mask == (1 << n) - 1) {
-        return 0;
+void TripPlanner::beginPlan(const std::vector<QString>& colleges) {
+    scratch = &PlannerWorkspace::forCurrentThread();
+    scratch->reset();
+    capacityMark = {{collegeList.capacity(), pathNames.capacity(), path.capacity(), legs.capacity(),
+                     legEstimated.capacity(), estimatedPairs.capacity()}};
+
+    // Copy assignment reuses collegeList's storage once it is large enough.
+    collegeList = colleges;
+    n = static_cast<int>(colleges.size());
+    spatialIndex = nullptr;
+    path.clear();
+    legs.clear();
+    legEstimated.clear();
+    estimatedPairs.clear();
+    totalCost = 0;
+    totalScore = 0;
+    exactSolve = false;
+    approximation = Exact;
+    roundTripCost = 0;
+}
+
+void TripPlanner::storePathNames() {
+    pathNames.resize(path.size());
+    for (size_t i = 0; i < path.size(); i++)
+        pathNames[i] = collegeList[path[i]];
+}
+
+void TripPlanner::endPlan() {
+    storePathNames();
+
+    std::array<size_t, 6> capacities = {{collegeList.capacity(), pathNames.capacity(), path.capacity(), legs.capacity(),
+                                         legEstimated.capacity(), estimatedPairs.capacity()}};
+    for (size_t i = 0; i < capacities.size(); i++) {
+        if (capacities[i] != capacityMark[i])
+            allocations++;
     }
+    // Nothing in the workspace outlives the plan; resetting now also folds any
+    // blocks it had to add into one, so that growth is charged to this plan.
+    scratch->reset();
+    scratch = nullptr;
+}
 
-    if (memo[curr][mask] != -1)
-        return memo[curr][mask];
+namespace {
+// Bottom-up endpoint DP shared by the fixed-size and general solvers. Size is either
+// std::integral_constant<int, N>, so the compiler sees the college count and can unroll
+// the inner loops, or a plain int. Both run the same operations in the same order, so
+// they produce identical trips.
+//
+// dp[mask * n + j] is the shortest path that starts at college 0, visits exactly
+// the colleges in mask and ends at j. Masks only grow, so one pass in increasing
+// mask order fills every layer, and the full-mask layer then answers the open
+// path, the round trip and every fixed endpoint at once.
+template <typename Size, typename Parent>
+void endpointDp(Size size, const double* cost, double* dp, Parent* parent, double* endCost, int* endPaths) {
+    const int n = size;
+    const double unreached = std::numeric_limits<double>::infinity();
+    // Pairs with no distance, recorded or estimated, are never used, so when every
+    // order needs one the full layer stays unreached.
+    const double missing = std::numeric_limits<double>::max() / 2;
+    const int full = (1 << n) - 1;
+    std::fill(dp, dp + (static_cast<size_t>(n) << n), unreached);
+    std::fill(parent, parent + (static_cast<size_t>(n) << n), Parent(-1));
+    dp[1 * n + 0] = 0;
 
-    double ans = std::numeric_limits<double>::max();
-    for (int i = 0; i < n; i++) {
-        if ((mask & (1 << i)) == 0) {
-            double newCost = cost[curr][i] + tspHelper(mask | (1 << i), i, cost);
-            if (newCost < ans) {
-                ans = newCost;
-                nextNode[curr][mask] = i;
+    for (int mask = 1; mask <= full; mask += 2) {
+        for (int j = 0; j < n; j++) {
+            double d = dp[mask * n + j];
+            if (d == unreached)
+                continue;
+            for (int k = 0; k < n; k++) {
+                if ((mask & (1 << k)) || cost[j * n + k] >= missing)
+                    continue;
+                int nextState = (mask | (1 << k)) * n + k;
+                double nd = d + cost[j * n + k];
+                if (nd < dp[nextState]) {
+                    dp[nextState] = nd;
+                    parent[nextState] = Parent(j);
+                }
             }
         }
     }
 
-    return memo[curr][mask] = ans;
+    // Keep the last layer and walk every endpoint's parent links back to the
+    // start now, so the tables can be dropped as soon as this returns.
+    for (int j = 0; j < n; j++) {
+        endCost[j] = dp[full * n + j];
+        if (endCost[j] == unreached)
+            continue;
+        int* order = endPaths + j * n;
+        int mask = full, curr = j, pos = n - 1;
+        while (curr >= 0) {
+            order[pos--] = curr;
+            int prev = parent[mask * n + curr];
+            mask &= ~(1 << curr);
+            curr = prev;
+        }
+    }
 }
 
-std::vector<int> TripPlanner::reconstructPath() {
-    int mask = 1, curr = 0;
-    std::vector<int> path;
-    path.push_back(curr);
+// Endpoint DP for exactly N colleges. N is at most TripPlanner::MaxFixedColleges,
+// so parents fit in a signed char.
+template <int N>
+void fixedEndpointDp(const double* cost, double* dp, signed char* parent, double* endCost, int* endPaths) {
+    endpointDp(std::integral_constant<int, N>(), cost, dp, parent, endCost, endPaths);
+}
+}
 
-    while (mask != (1 << n) - 1) {
-        int next = nextNode[curr][mask];
-        path.push_back(next);
-        curr = next;
-        mask |= (1 << next);
+void TripPlanner::runEndpointDp(const CostView &cost) {
+    // The tables come from the workspace even for small trips: at 12 colleges they
+    // already take about 440 KB, more than a worker thread's stack may hold.
+    double* dp = scratch->allocate<double>(static_cast<size_t>(n) << n);
+    if (n > MaxFixedColleges) {
+        int* parent = scratch->allocate<int>(static_cast<size_t>(n) << n);
+        endpointDp(n, cost.data, dp, parent, endCost.data(), endPaths.data());
+        return;
     }
 
-    return path;
+    signed char* parent = scratch->allocate<signed char>(static_cast<size_t>(n) << n);
+    switch (n) {
+    case 1: fixedEndpointDp<1>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 2: fixedEndpointDp<2>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 3: fixedEndpointDp<3>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 4: fixedEndpointDp<4>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 5: fixedEndpointDp<5>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 6: fixedEndpointDp<6>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 7: fixedEndpointDp<7>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 8: fixedEndpointDp<8>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 9: fixedEndpointDp<9>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 10: fixedEndpointDp<10>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 11: fixedEndpointDp<11>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    case 12: fixedEndpointDp<12>(cost.data, dp, parent, endCost.data(), endPaths.data()); break;
+    }
 }
 
-void TripPlanner::calculateTrip(const std::vector<QString>& colleges, DatabaseManager* dbManager) {
-    // Store the provided college list.
-    collegeList = colleges;
-    n = static_cast<int>(colleges.size());
-    
-    // Build the cost matrix. If a distance between two colleges isn’t found,
-    // uses (INF) to represent no direct connection.
+TripPlanner::CostView TripPlanner::prepareCost() {
+    // If a distance between two colleges isn't found, uses (INF) to represent no direct connection.
+    double INF = std::numeric_limits<double>::max() / 2;
+    CostView cost{exactCost.data(), n};
+    if (n > MaxExactColleges)
+        cost.data = scratch->allocate<double>(static_cast<size_t>(n) * n);
+    std::fill(cost.data, cost.data + static_cast<size_t>(n) * n, INF);
+    for (int i = 0; i < n; i++)
+        cost[i][i] = 0;
+    return cost;
+}
+
+void TripPlanner::calculateTrip(const std::vector<QString>& colleges, const DistanceGraph& graph) {
+    beginPlan(colleges);
+    spatialIndex = &graph.spatialIndex();
+    CostView costMatrix = prepareCost();
+    buildCostMatrix(graph, costMatrix);
+    solveTrip(costMatrix);
+    endPlan();
+}
+
+void TripPlanner::buildCostMatrix(const DistanceGraph& graph, const CostView& costMatrix) {
+    graphVersion = graph.version();
     double INF = std::numeric_limits<double>::max() / 2;
-    std::vector<std::vector<double>> costMatrix(n, std::vector<double>(n, INF));
+    int* ids = scratch->allocate<int>(n);
+    for (int i = 0; i < n; i++)
+        ids[i] = graph.idOf(collegeList[i]);
 
     for (int i = 0; i < n; i++) {
-        costMatrix[i][i] = 0;
-        // Get the distances from collegeList[i] to other colleges.
-        auto distances = dbManager->getDistances(colleges[i]);
-        // Update the cost matrix only for colleges that are in the provided list.
-        for (auto &p : distances) {
-            QString dest = p.first;
-            double dist = p.second;
-            // Find the index of the destination college in the list.
+        if (ids[i] < 0)
+            continue;
+        for (int j = 0; j < n; j++) {
+            if (i == j || ids[j] < 0)
+                continue;
+            double dist = graph.distance(ids[i], ids[j]);
+            if (dist < INF)
+                costMatrix[i][j] = dist;
+        }
+    }
+}
+
+void TripPlanner::estimateMissing(const CostView& costMatrix) {
+    // Estimate pairs with no recorded distance from campus coordinates, if known.
+    if (!spatialIndex)
+        return;
+    double INF = std::numeric_limits<double>::max() / 2;
+    estimatedPairs.assign(static_cast<size_t>(n) * n, false);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (costMatrix[i][j] < INF)
+                continue;
+            double estimate = spatialIndex->estimateMiles(collegeList[i], collegeList[j]);
+            if (estimate >= 0) {
+                costMatrix[i][j] = estimate;
+                estimatedPairs[static_cast<size_t>(i) * n + j] = true;
+            }
+        }
+    }
+}
+
+void TripPlanner::fillLegs(const CostView& costMatrix) {
+    legs.assign(path.size(), 0.0);
+    legEstimated.assign(path.size(), false);
+    for (size_t i = 1; i < path.size(); i++) {
+        legs[i] = costMatrix[path[i - 1]][path[i]];
+        if (!estimatedPairs.empty())
+            legEstimated[i] = estimatedPairs[static_cast<size_t>(path[i - 1]) * n + path[i]];
+    }
+}
+
+void TripPlanner::solveTrip(const CostView& costMatrix) {
+    if (n == 0)
+        return;
+
+    estimateMissing(costMatrix);
+
+    if (n <= MaxExactColleges) {
+        // Run the DP starting at the first college (index 0), then read the
+        // best open path and the best round trip off the last layer.
+        runEndpointDp(costMatrix);
+        int openEnd = 0;
+        roundTripEnd = 0;
+        roundTripCost = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < n; j++) {
+            if (endCost[j] < endCost[openEnd])
+                openEnd = j;
+            double withReturn = endCost[j] + costMatrix[j][0];
+            if (withReturn < roundTripCost) {
+                roundTripCost = withReturn;
+                roundTripEnd = j;
+            }
+        }
+        // Every order hits a missing distance only when the DP could not finish at all.
+        exactSolve = endCost[openEnd] != std::numeric_limits<double>::infinity();
+        if (exactSolve) {
+            totalCost = endCost[openEnd];
+            path.assign(endPaths.begin() + openEnd * n, endPaths.begin() + (openEnd + 1) * n);
+        }
+    }
+
+    if (!exactSolve) {
+        // Too many colleges for the exact DP, or no order avoids a missing distance;
+        // use a fast heuristic instead.
+        heuristicPath(costMatrix);
+        approximation = n <= MaxExactColleges ? MissingDistances : TooManyColleges;
+        totalCost = 0;
+        for (size_t i = 1; i < path.size(); i++)
+            totalCost += costMatrix[path[i - 1]][path[i]];
+        roundTripEnd = path.back();
+        roundTripCost = totalCost + costMatrix[roundTripEnd][0];
+    }
+    roundTripReturn = costMatrix[roundTripEnd][0];
+
+    fillLegs(costMatrix);
+}
+
+void TripPlanner::heuristicPath(const CostView &cost) {
+    // Nearest neighbour from the start college.
+    std::vector<int> &order = path;
+    order.clear();
+    bool* used = scratch->allocate<bool>(n);
+    std::fill(used, used + n, false);
+    int curr = 0;
+    used[0] = true;
+    order.push_back(0);
+    for (int step = 1; step < n; step++) {
+        int best = -1;
+        for (int j = 0; j < n; j++) {
+            if (!used[j] && (best < 0 || cost[curr][j] < cost[curr][best]))
+                best = j;
+        }
+        used[best] = true;
+        order.push_back(best);
+        curr = best;
+    }
+
+    twoOpt(order, cost);
+}
+
+bool TripPlanner::twoOpt(std::vector<int> &order, const CostView &cost) {
+    // 2-opt on the open path (the start stays first): reverse order[i..j] while
+    // that shortens the route. Gains are measured on the two changed joins, which
+    // is exact for symmetric distances.
+    const int maxPasses = 8;
+    int len = static_cast<int>(order.size());
+    bool changed = false;
+    for (int pass = 0; pass < maxPasses; pass++) {
+        bool improved = false;
+        for (int i = 1; i < len - 1; i++) {
+            for (int j = i + 1; j < len; j++) {
+                int a = order[i - 1], b = order[i], c = order[j];
+                double before = cost[a][b];
+                double after = cost[a][c];
+                if (j + 1 < len) {
+                    int d = order[j + 1];
+                    before += cost[c][d];
+                    after += cost[b][d];
+                }
+                if (after + 1e-9 < before) {
+                    std::reverse(order.begin() + i, order.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+        if (!improved)
+            break;
+        changed = true;
+    }
+    return changed;
+}
+
+void TripPlanner::calculateBudgetTrip(const std::vector<QString>& colleges, const std::vector<double>& scores,
+                                      double maxMiles, const DistanceGraph& graph) {
+    beginPlan(colleges);
+    spatialIndex = &graph.spatialIndex();
+    if (n == 0) {
+        endPlan();
+        return;
+    }
+
+    // Colleges without an explicit score are worth one visit each.
+    std::vector<double> score(n, 1.0);
+    for (int i = 0; i < n && i < static_cast<int>(scores.size()); i++)
+        score[i] = scores[i];
+
+    // Driving is never shorter than the great-circle distance, so a college farther than
+    // the budget from the start in a straight line cannot be on any trip. Dropping those
+    // up front shrinks the search, often enough to bring it within the exact DP.
+    if (spatialIndex) {
+        int kept = 1;
+        for (int i = 1; i < n; i++) {
+            if (spatialIndex->lowerBoundMiles(collegeList[0], collegeList[i]) > maxMiles)
+                continue;
+            collegeList[kept] = collegeList[i];
+            score[kept] = score[i];
+            kept++;
+        }
+        collegeList.resize(kept);
+        score.resize(kept);
+        n = kept;
+    }
+
+    CostView costMatrix = prepareCost();
+    buildCostMatrix(graph, costMatrix);
+    estimateMissing(costMatrix);
+
+    if (n > MaxExactBudgetColleges || !budgetSubsetDp(costMatrix, score, maxMiles)) {
+        budgetHeuristic(costMatrix, score, maxMiles);
+        approximation = TooManyColleges;
+    }
+
+    fillLegs(costMatrix);
+    for (size_t i = 0; i < path.size(); i++) {
+        totalCost += legs[i];
+        totalScore += score[path[i]];
+    }
+    roundTripEnd = path.back();
+    roundTripCost = totalCost + costMatrix[roundTripEnd][0];
+    roundTripReturn = costMatrix[roundTripEnd][0];
+    endPlan();
+}
+
+bool TripPlanner::budgetSubsetDp(const CostView &cost, const std::vector<double> &score,
+                                 double maxMiles) {
+    // Labels are (visited set, last college). Layer k holds the labels that have
+    // visited k + 1 colleges within the budget. A label is dominated by another
+    // with the same set and last college and fewer miles, so only the cheapest
+    // is kept; anything over budget is dropped immediately.
+    struct Label {
+        unsigned mask;
+        int last;
+        double miles;
+        double score;
+        int parent;
+    };
+    const size_t maxLabels = 400000;
+
+    std::vector<std::vector<Label>> layers;
+    layers.push_back(std::vector<Label>(1, Label{1u, 0, 0.0, score[0], -1}));
+    size_t labelCount = 1;
+    int bestLayer = 0, bestIndex = 0;
+    // Position of each (set, last) label in its layer. Sets in different layers have
+    // different sizes, so one table serves every layer without clearing.
+    int* slot = scratch->allocate<int>(static_cast<size_t>(n) << n);
+    std::fill(slot, slot + (static_cast<size_t>(n) << n), -1);
+
+    for (int k = 0; !layers[k].empty() && k + 1 < n; k++) {
+        layers.emplace_back();
+        const std::vector<Label> &current = layers[k];
+        std::vector<Label> &next = layers[k + 1];
+
+        for (int s = 0; s < static_cast<int>(current.size()); s++) {
+            const Label &from = current[s];
             for (int j = 0; j < n; j++) {
-                if (colleges[j] == dest) {
-                    costMatrix[i][j] = dist;
-                    break;
+                if (from.mask & (1u << j))
+                    continue;
+                double miles = from.miles + cost[from.last][j];
+                if (miles > maxMiles)
+                    continue;
+                unsigned mask = from.mask | (1u << j);
+                int &at = slot[static_cast<size_t>(mask) * n + j];
+                if (at < 0) {
+                    at = static_cast<int>(next.size());
+                    next.push_back(Label{mask, j, miles, from.score + score[j], s});
+                } else if (miles < next[at].miles) {
+                    next[at].miles = miles;
+                    next[at].parent = s;
                 }
             }
         }
+
+        labelCount += next.size();
+        if (labelCount > maxLabels)
+            return false;
+
+        // Best = highest score, then fewest miles.
+        for (int s = 0; s < static_cast<int>(next.size()); s++) {
+            const Label &best = layers[bestLayer][bestIndex];
+            if (next[s].score > best.score + 1e-9 ||
+                (next[s].score > best.score - 1e-9 && next[s].miles < best.miles))
+            {
+                bestLayer = k + 1;
+                bestIndex = s;
+            }
+        }
     }
 
-    // Initialize DP memo and nextNode tables.
-    memo.assign(n, std::vector<double>(1 << n, -1));
-    nextNode.assign(n, std::vector<int>(1 << n, -1));
+    path.assign(bestLayer + 1, 0);
+    for (int k = bestLayer, s = bestIndex; k >= 0; k--) {
+        path[k] = layers[k][s].last;
+        s = layers[k][s].parent;
+    }
+    return true;
+}
+
+void TripPlanner::budgetHeuristic(const CostView &cost, const std::vector<double> &score, double maxMiles) {
+    // Greedy insertion: repeatedly add the college with the best score per extra
+    // mile at its cheapest position. When nothing fits, shorten the route with
+    // 2-opt and try again with the miles that frees up.
+    std::vector<int> &order = path;
+    order.assign(1, 0);
+    bool* used = scratch->allocate<bool>(n);
+    std::fill(used, used + n, false);
+    used[0] = true;
+    double miles = 0;
+
+    while (true) {
+        int bestCollege = -1, bestPos = 0;
+        double bestRatio = -1, bestExtra = 0;
+        for (int j = 0; j < n; j++) {
+            // A college worth nothing would only use up miles.
+            if (used[j] || score[j] <= 0)
+                continue;
+            for (int p = 1; p <= static_cast<int>(order.size()); p++) {
+                double extra = cost[order[p - 1]][j];
+                if (p < static_cast<int>(order.size()))
+                    extra += cost[j][order[p]] - cost[order[p - 1]][order[p]];
+                if (miles + extra > maxMiles)
+                    continue;
+                double ratio = score[j] / (std::max(extra, 0.0) + 1e-6);
+                if (ratio > bestRatio) {
+                    bestRatio = ratio;
+                    bestCollege = j;
+                    bestPos = p;
+                    bestExtra = extra;
+                }
+            }
+        }
 
-    // Run the TSP DP starting at the first college (index 0) with mask 1.
-    totalCost = tspHelper(1, 0, costMatrix);
-    path = reconstructPath();
+        if (bestCollege < 0) {
+            if (!twoOpt(order, cost))
+                break;
+            miles = 0;
+            for (size_t i = 1; i < order.size(); i++)
+                miles += cost[order[i - 1]][order[i]];
+            continue;
+        }
+
+        order.insert(order.begin() + bestPos, bestCollege);
+        used[bestCollege] = true;
+        miles += bestExtra;
+    }
 }
 
 double TripPlanner::getTotalDistance() {
     return totalCost;
 }
 
-std::vector<QString> TripPlanner::getPath() {
-    std::vector<QString> collegePath;
-    // Map each index in the computed path to its college name.
-    for (int idx : path) {
-        collegePath.push_back(collegeList[idx]);
+const std::vector<QString>& TripPlanner::getPath() {
+    return pathNames;
+}
+
+double TripPlanner::getRoundTripDistance() {
+    if (roundTripCost >= std::numeric_limits<double>::max() / 2)
+        return std::numeric_limits<double>::infinity();
+    return roundTripCost;
+}
+
+double TripPlanner::getDistanceEndingAt(const QString& college) {
+    if (!exactSolve)
+        return std::numeric_limits<double>::infinity();
+    for (int j = 0; j < n; j++) {
+        // A trip that needed a missing distance has no real length.
+        if (collegeList[j] == college && endCost[j] < std::numeric_limits<double>::max() / 2)
+            return endCost[j];
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+bool TripPlanner::useRoundTrip() {
+    if (n < 2 || path.empty() || getRoundTripDistance() == std::numeric_limits<double>::infinity())
+        return false;
+    // Already closed by an earlier call.
+    if (path.size() > 1 && path.back() == 0)
+        return true;
+
+    if (exactSolve) {
+        path.assign(endPaths.begin() + roundTripEnd * n, endPaths.begin() + (roundTripEnd + 1) * n);
+        path.push_back(0);
+        fillLegs(CostView{exactCost.data(), n});
+    } else {
+        // The heuristic path already ends at roundTripEnd; only the way back is new.
+        path.push_back(0);
+        legs.push_back(roundTripReturn);
+        legEstimated.push_back(!estimatedPairs.empty() && estimatedPairs[static_cast<size_t>(roundTripEnd) * n]);
+    }
+    totalCost = roundTripCost;
+    storePathNames();
+    return true;
+}
+
+bool TripPlanner::useEndingAt(const QString& college) {
+    if (getDistanceEndingAt(college) == std::numeric_limits<double>::infinity())
+        return false;
+    for (int j = 0; j < n; j++) {
+        if (collegeList[j] == college) {
+            path.assign(endPaths.begin() + j * n, endPaths.begin() + (j + 1) * n);
+            fillLegs(CostView{exactCost.data(), n});
+            totalCost = endCost[j];
+            storePathNames();
+            return true;
+        }
     }
-    return collegePath;
-}
\ No newline at end of file
+    return false;
+}
+
+quint64 TripPlanner::getGraphVersion() {
+    return graphVersion;
+}
+
+double TripPlanner::getTotalScore() {
+    return totalScore;
+}
+
+TripPlanner::Approximation TripPlanner::getApproximation() {
+    return approximation;
+}
+
+const std::vector<double>& TripPlanner::getLegDistances() {
+    return legs;
+}
+
+const std::vector<bool>& TripPlanner::getEstimatedLegs() {
+    return legEstimated;
+}
+
+quint64 TripPlanner::getAllocationCount() {
+    return allocations;
+}
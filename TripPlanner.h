@@ -1,41 +1,160 @@
 #ifndef TRIPPLANNER_H
 #define TRIPPLANNER_H
 
+#include <array>
 #include <vector>
 #include <QString>
 #include <limits>
 
-// Forward declaration of DatabaseManager
-class DatabaseManager;
+// Forward declarations
+class PlannerWorkspace;
+class CampusSpatialIndex;
+class DistanceGraph;
 
 class TripPlanner {
+public:
+    // Largest trip solved exactly; bigger trips use a heuristic to stay interactive.
+    static const int MaxExactColleges = 15;
+    // Largest trip solved by the DP specialised for its exact college count (with
+    // one-byte parent links); bigger exact trips use the general DP. Both take their
+    // tables from the planner workspace, never the stack, so planning is safe on
+    // worker threads with small stacks.
+    static const int MaxFixedColleges = 12;
+    // Largest candidate list for which budget trips are solved exactly.
+    static const int MaxExactBudgetColleges = 16;
+
+    // Whether the last trip was solved exactly and, if not, why a heuristic was used.
+    enum Approximation {
+        Exact,
+        TooManyColleges,   // Too large (or too many options) for the exact solvers
+        MissingDistances   // Some pairs have no distance, recorded or estimated, so no exact order exists
+    };
+
 private:
+    // Row-major n x n cost matrix; cost[i][j] is the distance from college i to college j.
+    struct CostView {
+        double* data;
+        int n;
+        double* operator[](int i) const { return data + i * n; }
+    };
+
     // Stores the optimal trip as a list of indices (into collegeList)
     std::vector<int> path;
     // Total distance of the computed trip
     double totalCost;
+    // Sum of the scores of the colleges on a budget trip
+    double totalScore;
     // Number of colleges to visit
     int n;
     // The list of colleges provided by the user.
     std::vector<QString> collegeList;
-    // DP memo table: memo[current][mask] holds the minimal distance
-    std::vector<std::vector<double>> memo;
-    // Table to reconstruct the optimal path: nextNode[current][mask]
-    std::vector<std::vector<int>> nextNode;
-    // Recursive TSP helper using DP with bitmasking.
-    double tspHelper(int mask, int curr, const std::vector<std::vector<double>> &cost);
-    // Reconstructs the optimal path (as a vector of indices) based on nextNode.
-    std::vector<int> reconstructPath();
+    // College names along path, refreshed after every plan.
+    std::vector<QString> pathNames;
+    // Distance of each leg of the optimal trip; legs[0] is 0 for the start.
+    std::vector<double> legs;
+    // True for the legs whose distance is a coordinate estimate rather than a recorded one.
+    std::vector<bool> legEstimated;
+    // Row-major n x n flags marking the cost matrix entries filled in by estimateMissing.
+    std::vector<bool> estimatedPairs;
+    // Version of the graph snapshot the last trip was planned against (0 for database trips).
+    quint64 graphVersion;
+    // Campus locations of the graph being planned against (nullptr for database trips),
+    // used to estimate pairs with no recorded distance and to prune budget trips.
+    const CampusSpatialIndex* spatialIndex;
+    // Workspace of the plan in progress (the calling thread's own); scratch tables are taken from it.
+    PlannerWorkspace* scratch;
+    // Number of times a result buffer had to grow, and their capacities before the current plan.
+    quint64 allocations;
+    std::array<size_t, 6> capacityMark;
+    // Cost matrix of the last exact-sized trip, kept so useRoundTrip and useEndingAt can
+    // rebuild the leg distances after the plan
+    std::array<double, MaxExactColleges * MaxExactColleges> exactCost;
+    // Last DP layer: endCost[j] is the shortest path through every college ending at j
+    std::array<double, MaxExactColleges> endCost;
+    // Row j (stride n) holds the path behind endCost[j], start first
+    std::array<int, MaxExactColleges * MaxExactColleges> endPaths;
+    // True when the last trip came from the exact DP (so endCost and endPaths are valid)
+    bool exactSolve;
+    // How the last trip was solved
+    Approximation approximation;
+    // Last stop and length of the best round trip back to the start, and its final leg
+    int roundTripEnd;
+    double roundTripCost;
+    double roundTripReturn;
+
+    // Resets the results and the workspace and stores the college list for a new plan.
+    void beginPlan(const std::vector<QString>& colleges);
+    // Fills pathNames and counts any result buffers that had to grow.
+    void endPlan();
+    void storePathNames();
+    // Returns an n x n matrix with 0 on the diagonal and "no connection" elsewhere,
+    // stored in exactCost when n <= MaxExactColleges and in the workspace otherwise.
+    CostView prepareCost();
+    // Bottom-up TSP DP with bitmasking over every end state, filling endCost and endPaths.
+    void runEndpointDp(const CostView &cost);
+    // Fills the cost matrix for collegeList from the in-memory graph.
+    void buildCostMatrix(const DistanceGraph &graph, const CostView &cost);
+    // Replaces missing distances with coordinate estimates when a spatial index is set,
+    // recording which ones in estimatedPairs.
+    void estimateMissing(const CostView &cost);
+    // Fills legs and legEstimated for the current path.
+    void fillLegs(const CostView &cost);
+    // Plans the trip over a filled cost matrix.
+    void solveTrip(const CostView &cost);
+    // Nearest neighbour tour improved with 2-opt, for trips too large for the DP; fills path.
+    void heuristicPath(const CostView &cost);
+    // Shortens an open path in place with 2-opt; returns true if anything changed.
+    bool twoOpt(std::vector<int> &order, const CostView &cost);
+    // Exact budget trip by subset DP over (visited set, last college) labels.
+    // Returns false if the label count grows too large, leaving path untouched.
+    bool budgetSubsetDp(const CostView &cost, const std::vector<double> &score, double maxMiles);
+    // Greedy score-per-mile insertion with 2-opt, for budget trips too large for the DP; fills path.
+    void budgetHeuristic(const CostView &cost, const std::vector<double> &score, double maxMiles);
 
 public:
     TripPlanner();
-    // Given a list of colleges and a pointer to the database manager,
-    // calculates the optimal trip and total distance to be called with getTotalDistance and getPath.
-    void calculateTrip(const std::vector<QString>& colleges, DatabaseManager* dbManager);
+    // Given a list of colleges and an in-memory distance graph, calculates the optimal
+    // trip and total distance to be called with getTotalDistance and getPath.
+    // Missing distances are estimated from the same graph's campus locations.
+    void calculateTrip(const std::vector<QString>& colleges, const DistanceGraph& graph);
+    // Budget mode: starting at colleges[0], picks the subset and order of colleges that
+    // maximizes the total score (scores[i], default 1 per college) without driving more
+    // than maxMiles. With a spatial index, colleges whose great-circle distance from the
+    // start is over budget are dropped before planning. The result is read back with
+    // getPath, getTotalDistance and getTotalScore.
+    void calculateBudgetTrip(const std::vector<QString>& colleges, const std::vector<double>& scores,
+                             double maxMiles, const DistanceGraph& graph);
     // Returns the total distance (cost) of the most recent trip.
     double getTotalDistance();
-    // Returns the optimal trip as a list of college names.
-    std::vector<QString> getPath();
+    // Returns the optimal trip as a list of college names, valid until the next plan.
+    const std::vector<QString>& getPath();
+    // Returns the length of the best trip that returns to the start college
+    // (infinity if some college has no way back).
+    double getRoundTripDistance();
+    // Returns the shortest distance of a trip through every college that ends at the given one
+    // (infinity if unknown or the trip was planned heuristically).
+    double getDistanceEndingAt(const QString& college);
+    // Makes the best round trip the current result, so getPath and the other accessors
+    // describe it, ending back at the start college. Returns false if there is none.
+    bool useRoundTrip();
+    // Makes the trip matching getDistanceEndingAt the current result. Returns false if
+    // it is unavailable, leaving the result unchanged.
+    bool useEndingAt(const QString& college);
+    // Returns the version of the graph the most recent trip was planned against,
+    // so a cached result can be checked against DistanceGraphStore::version().
+    quint64 getGraphVersion();
+    // Returns the total score of the most recent budget trip.
+    double getTotalScore();
+    // Returns whether the most recent trip was planned heuristically and why; a shorter
+    // or higher-scoring trip may exist unless this is Exact.
+    Approximation getApproximation();
+    // Returns the distance of each leg of the optimal trip, aligned with getPath().
+    const std::vector<double>& getLegDistances();
+    // Returns which legs of the trip are coordinate estimates, aligned with getLegDistances().
+    const std::vector<bool>& getEstimatedLegs();
+    // Number of times this planner's result buffers had to grow. Together with
+    // PlannerWorkspace::allocationCount() this stays flat once planning reaches a steady state.
+    quint64 getAllocationCount();
 };
 
 #endif // TRIPPLANNER_H
\ No newline at end of file
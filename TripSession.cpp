@@ -0,0 +1,285 @@
+#include "TripSession.h"
+#include <QBitArray>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace {
+// Identifies a trip session file and its layout version.
+const quint32 SessionMagic = 0x54524950; // "TRIP"
+const quint16 SessionVersion = 3;
+// Identifies the purchase journal kept beside a session file.
+const quint32 JournalMagic = 0x54524a4c; // "TRJL"
+
+// Smallest encoding of a stop (empty name, leg) and of a purchase (route
+// position, empty name, price, quantity), used to reject impossible counts.
+const qint64 MinStopBytes = 4 + 8;
+const qint64 MinPurchaseBytes = 4 + 4 + 8 + 4;
+
+QString journalPath(const QString& filePath) {
+    return filePath + ".journal";
+}
+
+// Purchases refer to their college by route position; the name is only
+// written for purchases made somewhere off the route.
+void writePurchase(QDataStream& out, const PurchasedSouvenir& ps, qint32 position) {
+    out << position;
+    if (position < 0)
+        out << ps.college;
+    out << ps.souvenirName << ps.price << qint32(ps.quantity);
+}
+
+bool readPurchase(QDataStream& in, const std::vector<QString>& route, PurchasedSouvenir& ps) {
+    qint32 position = -1;
+    qint32 quantity = 0;
+    in >> position;
+    if (position >= 0 && position < static_cast<qint32>(route.size()))
+        ps.college = route[position];
+    else
+        in >> ps.college;
+    in >> ps.souvenirName >> ps.price >> quantity;
+    ps.quantity = quantity;
+    return in.status() == QDataStream::Ok;
+}
+}
+
+TripSession::TripSession() : current(-1), journalId(0) { }
+
+void TripSession::start(const std::vector<QString>& route, const std::vector<double>& legs,
+                        const std::vector<bool>& estimated) {
+    clear();
+    stops = route;
+    legDistances = legs;
+    legDistances.resize(stops.size(), 0.0);
+    legEstimated = estimated;
+    legEstimated.resize(stops.size(), false);
+    visited.assign(stops.size(), false);
+    for (int i = 0; i < static_cast<int>(stops.size()); i++)
+        positionOf.insert(stops[i], i);
+}
+
+void TripSession::clear() {
+    stops.clear();
+    legDistances.clear();
+    legEstimated.clear();
+    positionOf.clear();
+    visited.clear();
+    purchaseList.clear();
+    current = -1;
+}
+
+bool TripSession::isActive() const {
+    return !stops.empty();
+}
+
+void TripSession::markVisited(int position) {
+    if (position >= 0 && position < static_cast<int>(visited.size()))
+        visited[position] = true;
+}
+
+TripSession::Step TripSession::advance() {
+    markVisited(current);
+    if (current >= static_cast<int>(stops.size()) - 1)
+        return Finished;
+    current++;
+    return Moved;
+}
+
+int TripSession::cursor() const {
+    return current;
+}
+
+int TripSession::stopCount() const {
+    return static_cast<int>(stops.size());
+}
+
+const QString& TripSession::stop(int position) const {
+    return stops[position];
+}
+
+const std::vector<QString>& TripSession::route() const {
+    return stops;
+}
+
+const std::vector<double>& TripSession::legs() const {
+    return legDistances;
+}
+
+const std::vector<bool>& TripSession::estimatedLegs() const {
+    return legEstimated;
+}
+
+double TripSession::totalDistance() const {
+    double total = 0.0;
+    for (double leg : legDistances)
+        total += leg;
+    return total;
+}
+
+bool TripSession::hasEstimates() const {
+    return std::find(legEstimated.begin(), legEstimated.end(), true) != legEstimated.end();
+}
+
+bool TripSession::isVisited(int position) const {
+    return position >= 0 && position < static_cast<int>(visited.size()) && visited[position];
+}
+
+void TripSession::addPurchase(const PurchasedSouvenir& purchase) {
+    purchaseList.push_back(purchase);
+}
+
+const std::vector<PurchasedSouvenir>& TripSession::purchases() const {
+    return purchaseList;
+}
+
+bool TripSession::save(const QString& filePath) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to save trip session:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    quint32 nextJournalId = journalId + 1;
+    out << SessionMagic << SessionVersion << nextJournalId;
+
+    out << quint32(stops.size());
+    for (size_t i = 0; i < stops.size(); i++)
+        out << stops[i] << legDistances[i];
+    out << qint32(current);
+
+    QBitArray visitedBits(static_cast<int>(visited.size()));
+    QBitArray estimatedBits(static_cast<int>(legEstimated.size()));
+    for (int i = 0; i < static_cast<int>(visited.size()); i++) {
+        visitedBits.setBit(i, visited[i]);
+        estimatedBits.setBit(i, legEstimated[i]);
+    }
+    out << visitedBits << estimatedBits;
+
+    out << quint32(purchaseList.size());
+    for (const PurchasedSouvenir& ps : purchaseList)
+        writePurchase(out, ps, positionOf.value(ps.college, -1));
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "Failed to save trip session:" << file.errorString();
+        return false;
+    }
+    journalId = nextJournalId;
+    // Every journalled purchase is in the file now. If this is not reached the
+    // old journal is still ignored on load, because its id no longer matches.
+    QFile::remove(journalPath(filePath));
+    return true;
+}
+
+bool TripSession::journalPurchase(const QString& filePath, const PurchasedSouvenir& purchase) const {
+    QFile file(journalPath(filePath));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Failed to journal purchase:" << file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    if (file.size() == 0)
+        out << JournalMagic << SessionVersion << journalId;
+    writePurchase(out, purchase, positionOf.value(purchase.college, -1));
+    if (out.status() != QDataStream::Ok || !file.flush()) {
+        qDebug() << "Failed to journal purchase:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void TripSession::remove(const QString& filePath) {
+    QFile::remove(filePath);
+    QFile::remove(journalPath(filePath));
+}
+
+bool TripSession::load(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    // Version 1 files have no estimate flags; their legs all read as recorded distances.
+    // Versions before 3 have no journal.
+    if (magic != SessionMagic || version < 1 || version > SessionVersion) {
+        qDebug() << "Ignoring unrecognised trip session file:" << filePath;
+        return false;
+    }
+    quint32 savedJournalId = 0;
+    if (version >= 3)
+        in >> savedJournalId;
+
+    // Counts come straight from the file; check they fit in it before allocating.
+    quint32 stopTotal = 0;
+    in >> stopTotal;
+    if (in.status() != QDataStream::Ok || stopTotal > (file.size() - file.pos()) / MinStopBytes) {
+        qDebug() << "Trip session file is corrupt:" << filePath;
+        return false;
+    }
+    std::vector<QString> route(stopTotal);
+    std::vector<double> legs(stopTotal);
+    for (quint32 i = 0; i < stopTotal && in.status() == QDataStream::Ok; i++)
+        in >> route[i] >> legs[i];
+    qint32 cursor = -1;
+    in >> cursor;
+    QBitArray visitedBits;
+    in >> visitedBits;
+    QBitArray estimatedBits(static_cast<int>(stopTotal));
+    if (version >= 2)
+        in >> estimatedBits;
+
+    quint32 purchaseTotal = 0;
+    in >> purchaseTotal;
+    if (in.status() != QDataStream::Ok || purchaseTotal > (file.size() - file.pos()) / MinPurchaseBytes) {
+        qDebug() << "Trip session file is corrupt:" << filePath;
+        return false;
+    }
+    std::vector<PurchasedSouvenir> loadedPurchases;
+    loadedPurchases.reserve(purchaseTotal);
+    for (quint32 i = 0; i < purchaseTotal && in.status() == QDataStream::Ok; i++) {
+        PurchasedSouvenir ps;
+        readPurchase(in, route, ps);
+        loadedPurchases.push_back(ps);
+    }
+
+    if (in.status() != QDataStream::Ok || stopTotal == 0 || cursor < -1 || cursor >= static_cast<qint32>(stopTotal)
+        || visitedBits.size() != static_cast<int>(stopTotal) || estimatedBits.size() != static_cast<int>(stopTotal)) {
+        qDebug() << "Trip session file is corrupt:" << filePath;
+        return false;
+    }
+
+    std::vector<bool> estimated(stopTotal);
+    for (int i = 0; i < estimatedBits.size(); i++)
+        estimated[i] = estimatedBits.testBit(i);
+    start(route, legs, estimated);
+    current = cursor;
+    for (int i = 0; i < visitedBits.size(); i++)
+        visited[i] = visitedBits.testBit(i);
+    purchaseList = std::move(loadedPurchases);
+    journalId = savedJournalId;
+
+    // Replay purchases journalled after that save. A record cut short by a
+    // crash is dropped, and so is a journal left over from an earlier save.
+    QFile journal(journalPath(filePath));
+    if (version >= 3 && journal.open(QIODevice::ReadOnly)) {
+        QDataStream jin(&journal);
+        quint32 journalMagic = 0;
+        quint16 journalVersion = 0;
+        quint32 id = 0;
+        jin >> journalMagic >> journalVersion >> id;
+        if (jin.status() == QDataStream::Ok && journalMagic == JournalMagic && id == journalId) {
+            while (!jin.atEnd()) {
+                PurchasedSouvenir ps;
+                if (!readPurchase(jin, stops, ps))
+                    break;
+                purchaseList.push_back(ps);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef TRIPSESSION_H
+#define TRIPSESSION_H
+
+#include <QString>
+#include <QHash>
+#include <vector>
+#include "PurchaseLedger.h"
+
+// State of the trip currently being toured: the planned route, the stop the
+// user is at, which stops have been visited and what was bought along the way.
+// Stepping and visited checks are constant time. The whole session can be
+// written to a small binary file and read back so a tour survives a restart.
+// Purchases made since the last save go to an append-only journal next to that
+// file, so recording one does not rewrite the session.
+class TripSession {
+public:
+    // Result of advance().
+    enum Step {
+        Moved,     // The cursor moved to the next stop.
+        Finished   // The last stop was completed; the trip is over.
+    };
+
+    TripSession();
+
+    // Starts a new trip over the given route; legs[i] is the distance from route[i - 1] to route[i]
+    // and estimated[i] is true if that distance is an estimate rather than a recorded one.
+    void start(const std::vector<QString>& route, const std::vector<double>& legs,
+               const std::vector<bool>& estimated);
+    // Forgets the current trip.
+    void clear();
+    // True once a route has been planned and until it is finished or cleared.
+    bool isActive() const;
+
+    // Marks the current stop visited and moves to the next one.
+    Step advance();
+    // Index of the current stop, or -1 before the first stop is reached.
+    int cursor() const;
+    int stopCount() const;
+    const QString& stop(int position) const;
+    const std::vector<QString>& route() const;
+    const std::vector<double>& legs() const;
+    const std::vector<bool>& estimatedLegs() const;
+    double totalDistance() const;
+    // True if any leg of the route is an estimate.
+    bool hasEstimates() const;
+    // Returns true if the stop at the given route position has been visited.
+    bool isVisited(int position) const;
+
+    // Records a purchase made on this trip.
+    void addPurchase(const PurchasedSouvenir& purchase);
+    const std::vector<PurchasedSouvenir>& purchases() const;
+
+    // Writes the whole session to disk and empties the purchase journal; returns true if successful.
+    bool save(const QString& filePath);
+    // Appends one purchase to the journal of the session saved at filePath; returns true if successful.
+    bool journalPurchase(const QString& filePath, const PurchasedSouvenir& purchase) const;
+    // Replaces the session with the one stored on disk, including journalled purchases;
+    // returns true if successful.
+    bool load(const QString& filePath);
+    // Deletes a saved session and its journal.
+    static void remove(const QString& filePath);
+
+private:
+    std::vector<QString> stops;
+    std::vector<double> legDistances;
+    std::vector<bool> legEstimated;
+    // Route position of every stop, used to store purchases compactly.
+    QHash<QString, int> positionOf;
+    std::vector<bool> visited;
+    std::vector<PurchasedSouvenir> purchaseList;
+    int current;
+    // Changes on every save; a journal only applies to the save it was started after.
+    quint32 journalId;
+
+    void markVisited(int position);
+};
+
+#endif // TRIPSESSION_H
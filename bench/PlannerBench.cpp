@@ -0,0 +1,119 @@
+// Trip planning throughput benchmark (not part of the application).
+// Plans the same size of trip over and over on 1, 2, 4 and 8 threads, each with its
+// own TripPlanner and thread-local PlannerWorkspace, over a synthetic campus graph.
+// Reports plans per second and the allocations made after each thread's first plan,
+// which should be zero once the workspaces have warmed up.
+//
+// Usage: PlannerBench [trip size] [plans per thread]
+
+#include "TripPlanner.h"
+#include "DistanceGraph.h"
+#include "PlannerWorkspace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTextStream>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+// Number of campuses in the synthetic graph.
+const int CampusCount = 200;
+
+// Campuses scattered over a 1000 x 1000 mile square, every pair connected by its
+// straight-line distance. A fixed linear congruential sequence keeps runs comparable.
+DistanceGraph syntheticGraph() {
+    std::vector<QString> names;
+    std::vector<std::pair<double, double>> points;
+    quint32 seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / double(1 << 24) * 1000.0;
+    };
+    for (int i = 0; i < CampusCount; i++) {
+        names.push_back(QString("Campus %1").arg(i));
+        double x = next();
+        points.emplace_back(x, next());
+    }
+
+    std::vector<DistanceEdge> edges;
+    for (int a = 0; a < CampusCount; a++) {
+        for (int b = a + 1; b < CampusCount; b++) {
+            double dx = points[a].first - points[b].first;
+            double dy = points[a].second - points[b].second;
+            edges.push_back(DistanceEdge{names[a], names[b], std::sqrt(dx * dx + dy * dy)});
+        }
+    }
+    DistanceGraph graph;
+    graph.build(edges, std::vector<CampusCoordinate>());
+    return graph;
+}
+
+// Returns plans per second; steadyAllocations receives the allocations made after
+// every thread's first plan.
+double planInParallel(const DistanceGraph &graph, int threads, int plansPerThread, int tripSize,
+                      quint64 &steadyAllocations) {
+    std::atomic<long> completed(0);
+    std::atomic<quint64> allocated(0);
+    std::vector<std::unique_ptr<QThread>> workers;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(QThread::create([&graph, &completed, &allocated, t, plansPerThread, tripSize]() {
+            // Consecutive windows of campuses keep every trip the same size.
+            TripPlanner planner;
+            PlannerWorkspace &workspace = PlannerWorkspace::forCurrentThread();
+            std::vector<QString> trip(tripSize);
+            quint64 warmedUp = 0;
+            for (int q = 0; q < plansPerThread; q++) {
+                for (int i = 0; i < tripSize; i++)
+                    trip[i] = graph.name((t + q + i) % graph.size());
+                planner.calculateTrip(trip, graph);
+                if (q == 0)
+                    warmedUp = workspace.allocationCount() + planner.getAllocationCount();
+                completed++;
+            }
+            allocated += workspace.allocationCount() + planner.getAllocationCount() - warmedUp;
+        }));
+        workers.back()->start();
+    }
+    for (auto &worker : workers)
+        worker->wait();
+
+    steadyAllocations = allocated;
+    double seconds = timer.nsecsElapsed() / 1e9;
+    return seconds > 0 ? completed / seconds : 0;
+}
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int tripSize = args.size() > 1 ? args[1].toInt() : 8;
+    int plansPerThread = args.size() > 2 ? args[2].toInt() : 2000;
+    QTextStream out(stdout);
+    if (tripSize < 2 || tripSize > CampusCount || plansPerThread <= 0) {
+        out << "Usage: PlannerBench [trip size 2-" << CampusCount << "] [plans per thread]\n";
+        return 1;
+    }
+
+    DistanceGraph graph = syntheticGraph();
+    out << "Planning " << tripSize << "-campus trips, " << plansPerThread << " per thread\n";
+    double single = 0;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        quint64 allocations = 0;
+        double rate = planInParallel(graph, threads, plansPerThread, tripSize, allocations);
+        if (threads == 1)
+            single = rate;
+        out << QString("%1 thread(s): %2 plans/s (%3x), %4 allocations after warm-up\n")
+                   .arg(threads)
+                   .arg(rate, 0, 'f', 0)
+                   .arg(single > 0 ? rate / single : 0, 0, 'f', 2)
+                   .arg(allocations);
+        out.flush();
+    }
+    return 0;
+}
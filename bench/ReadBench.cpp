@@ -0,0 +1,81 @@
+// Database read throughput benchmark (not part of the application).
+// Runs the same read workload on 1, 2, 4 and 8 threads. Each thread looks up the
+// distances and souvenirs of every college in turn through its own WAL-mode
+// connection from DatabaseManager. Reports the combined queries per second and
+// the speed-up over one thread.
+//
+// Usage: ReadBench [database file] [lookups per thread]
+// Point it at a copy of the application's campus.db so the tables are populated.
+
+#include "DatabaseManager.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTextStream>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+// Returns queries per second over all threads.
+double readInParallel(DatabaseManager &db, const std::vector<QString> &colleges, int threads,
+                      int lookupsPerThread) {
+    std::atomic<long> completed(0);
+    std::vector<std::unique_ptr<QThread>> workers;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(QThread::create([&db, &colleges, &completed, t, lookupsPerThread]() {
+            // Each worker reads through its own connection.
+            for (int q = 0; q < lookupsPerThread; q++) {
+                const QString &college = colleges[(t + q) % colleges.size()];
+                db.getDistances(college);
+                db.getSouvenirs(college);
+                completed += 2;
+            }
+            db.releaseThreadConnection();
+        }));
+        workers.back()->start();
+    }
+    for (auto &worker : workers)
+        worker->wait();
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    return seconds > 0 ? completed / seconds : 0;
+}
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    QString dbPath = args.size() > 1 ? args[1] : QString("campus.db");
+    int lookupsPerThread = args.size() > 2 ? args[2].toInt() : 500;
+    QTextStream out(stdout);
+    if (lookupsPerThread <= 0) {
+        out << "Usage: ReadBench [database file] [lookups per thread]\n";
+        return 1;
+    }
+
+    DatabaseManager db(dbPath);
+    std::vector<QString> colleges = db.getColleges();
+    if (colleges.empty()) {
+        out << "No colleges in " << dbPath << "; run the application once to import them.\n";
+        return 1;
+    }
+
+    out << "Reading " << colleges.size() << " colleges from " << dbPath << ", "
+        << lookupsPerThread << " lookups per thread\n";
+    double single = 0;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        double rate = readInParallel(db, colleges, threads, lookupsPerThread);
+        if (threads == 1)
+            single = rate;
+        out << QString("%1 thread(s): %2 queries/s (%3x)\n")
+                   .arg(threads)
+                   .arg(rate, 0, 'f', 0)
+                   .arg(single > 0 ? rate / single : 0, 0, 'f', 2);
+        out.flush();
+    }
+    return 0;
+}
@@ -3,20 +3,34 @@
 #include "TripPlanner.h"
 
 #include <QCoreApplication>
+#include <QFile>
 #include <QDebug>
 #include <QMessageBox>
 #include <QListWidgetItem>
 #include <QInputDialog>
 #include <QLineEdit>
+#include <QCompleter>
+#include <QStringListModel>
 #include <QMenu>
+#include <QThread>
+#include <QFileDialog>
+#include <QElapsedTimer>
 #include <algorithm>   
 #include <vector>
 
+// Where the trip in progress is kept between runs (next to campus.db).
+static const char *const TripSessionFile = "tripsession.dat";
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow), listLocked(false)
 {
     ui->setupUi(this);
 
+    ledger = new PurchaseLedger(this);
+    ui->treeViewPurchasedSouvenirs->setModel(ledger);
+    campusModel = new CampusListModel(this);
+    ui->listViewDistances->setModel(campusModel);
+
     // Initialize DatabaseManager (assumes campus.db is in the working directory (build)).
     dbManager = new DatabaseManager("campus.db");
     // listWidgetSelectedColleges = findChild<QListWidget*>("listWidgetSelectedColleges");
@@ -24,11 +38,11 @@ MainWindow::MainWindow(QWidget *parent)
     QString appDir = QCoreApplication::applicationDirPath();
     QString distancesFile = appDir + "/collegedistances.csv";
     QString souvenirsFile = appDir + "/souvenirslist.csv";
+    QString coordinatesFile = appDir + "/campuscoordinates.csv";
 
-    QStringList distanceColumns = {"start_college", "end_college", "distance"};
     QStringList souvenirColumns = {"college", "souvenir", "price"};
 
-    if (dbManager->importCSV(distancesFile, "Distances", distanceColumns)) {
+    if (dbManager->importDistances(distancesFile)) {
         qDebug() << "Imported distances successfully.";
     } else {
         qDebug() << "Failed to import distances.";
@@ -40,40 +54,86 @@ MainWindow::MainWindow(QWidget *parent)
         qDebug() << "Failed to import souvenirs.";
     }
 
+    // Campus locations are optional; without them the graph's spatial index is just empty.
+    if (!dbManager->importCoordinates(coordinatesFile)) {
+        qDebug() << "No campus coordinates imported.";
+    }
+    rebuildDistanceGraph();
+
+    reportImportIssues(false);
+
     // Populate the combo box with colleges from the database.
     updateCollegeComboBox();
+    souvenirNames.assign(dbManager->getSouvenirNames());
+
+    // Type-ahead over campus names; picking a match selects it in the combo box.
+    ui->comboBoxColleges->setEditable(true);
+    ui->comboBoxColleges->setInsertPolicy(QComboBox::NoInsert);
+    // The completer sits on the line edit and has its own model, so the combo box does not see
+    // a match being picked; select it here so the distance list follows straight away.
+    QCompleter *collegeCompleter = attachNameCompleter(ui->comboBoxColleges->lineEdit(), &collegeNames);
+    connect(collegeCompleter, QOverload<const QString &>::of(&QCompleter::activated),
+            this, [this](const QString &college) {
+        int index = ui->comboBoxColleges->findText(college);
+        if (index >= 0)
+            ui->comboBoxColleges->setCurrentIndex(index);
+    });
 
     // Connect signals:
-    ui->listWidgetDistances->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(ui->listWidgetDistances, &QListWidget::customContextMenuRequested, 
+    ui->listViewDistances->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->listViewDistances, &QListView::customContextMenuRequested, 
             this, &MainWindow::onListWidgetContextMenuRequested);
-    connect(ui->comboBoxColleges, &QComboBox::currentTextChanged,
-            this, &MainWindow::onCollegeChanged);
-    connect(ui->listWidgetDistances, &QListWidget::itemClicked,
+    // The combo box is editable, so follow the selected item rather than the typed text.
+    connect(ui->comboBoxColleges, &QComboBox::currentIndexChanged,
+            this, [this]() { onCollegeChanged(selectedCollege()); });
+    connect(ui->listViewDistances, &QListView::clicked,
             this, &MainWindow::onDistanceItemClicked);
     connect(ui->lockButton, &QPushButton::clicked,
             this, &MainWindow::onLockButtonClicked);
+    connect(ui->autoTourButton, &QPushButton::clicked,
+            this, &MainWindow::onAutoTourButtonClicked);
+    connect(ui->budgetTourButton, &QPushButton::clicked,
+            this, &MainWindow::onBudgetTourButtonClicked);
     connect(ui->nextButton, &QPushButton::clicked, 
             this, &MainWindow::onNextButtonClicked);
     connect(ui->listWidgetSouvenirs, &QListWidget::itemDoubleClicked,
             this, &MainWindow::onSouvenirDoubleClicked);
     connect(ui->maintenanceButton, &QPushButton::clicked,
             this, &MainWindow::onMaintenanceButtonClicked);
+
+    // Pick up a trip that was still in progress when the app last closed.
+    restoreSession();
 }
 
 MainWindow::~MainWindow() {
+    // Fold any journalled purchases back into the session file.
+    saveSession();
+    // A souvenir prefetch still running would be using the database manager.
+    for (QThread *prefetch : souvenirPrefetches) {
+        prefetch->wait();
+        delete prefetch;
+    }
     delete dbManager;
     delete ui;
 }
 
 void MainWindow::onCollegeChanged(const QString &college) {
+    // While a trip is in progress the list shows its stops, and the session indexes them by row.
+    if (session.isActive())
+        return;
     updateDistanceList(college);
 }
 
+void MainWindow::updateTripControls() {
+    // The start college can only change once the trip is unlocked or finished.
+    ui->comboBoxColleges->setEnabled(!session.isActive());
+}
+
 void MainWindow::updateCollegeComboBox() {
-    QString currentSelection = ui->comboBoxColleges->currentText(); // Save the current selection
+    QString currentSelection = selectedCollege(); // Save the current selection
     ui->comboBoxColleges->clear(); // Clear the combo box
     std::vector<QString> colleges = dbManager->getColleges(); // Get colleges from DB
+    collegeNames.assign(colleges);
     for (const QString &college : colleges) {
         ui->comboBoxColleges->addItem(college);
     }
@@ -89,78 +149,199 @@ void MainWindow::updateCollegeComboBox() {
     }
 }
 
+QString MainWindow::selectedCollege() const {
+    int index = ui->comboBoxColleges->currentIndex();
+    return index >= 0 ? ui->comboBoxColleges->itemText(index) : QString();
+}
+
+QCompleter *MainWindow::attachNameCompleter(QLineEdit *edit, const NameIndex *index) {
+    // The popup shows the index's matches as they are; the completer does no filtering of its own.
+    QStringListModel *matches = new QStringListModel(edit);
+    QCompleter *completer = new QCompleter(matches, edit);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    edit->setCompleter(completer);
+    connect(edit, &QLineEdit::textEdited, completer, [matches, completer, index](const QString &text) {
+        matches->setStringList(index->search(text));
+        completer->complete();
+    });
+    return completer;
+}
+
+QString MainWindow::promptForName(const QString &title, const QString &label, const NameIndex *index) {
+    QInputDialog dialog(this);
+    dialog.setWindowTitle(title);
+    dialog.setLabelText(label);
+    dialog.setInputMode(QInputDialog::TextInput);
+    if (QLineEdit *edit = dialog.findChild<QLineEdit *>())
+        attachNameCompleter(edit, index);
+    if (dialog.exec() != QDialog::Accepted)
+        return QString();
+    return dialog.textValue().trimmed();
+}
+
 void MainWindow::onListWidgetContextMenuRequested(const QPoint &pos) {
-    QListWidgetItem* item = ui->listWidgetDistances->itemAt(pos);
-    if (!item)
+    QModelIndex index = ui->listViewDistances->indexAt(pos);
+    if (!index.isValid())
         return;
 
-    // Prevent toggling the highlight for the starting college
-    if (item->data(Qt::UserRole).toString() == "starting") {
-        return;
-    }
+    int row = index.row();
+    QString college = campusModel->collegeAt(row);
 
     QMenu contextMenu(this);
-    QAction* toggleHighlightAction = new QAction("Select College", this);
-    connect(toggleHighlightAction, &QAction::triggered, this, [this, item]() {
-        toggleItemHighlight(item);
+    // Prevent toggling the highlight for the starting college
+    if (!campusModel->isReference(row)) {
+        QAction* toggleHighlightAction = new QAction("Select College", &contextMenu);
+        connect(toggleHighlightAction, &QAction::triggered, this, [this, row]() {
+            toggleItemHighlight(row);
+        });
+        contextMenu.addAction(toggleHighlightAction);
+    }
+    if (shapePlanner && session.cursor() < 0 && session.purchases().empty()) {
+        QAction* shapeAction = new QAction("Change Trip Ending...", &contextMenu);
+        connect(shapeAction, &QAction::triggered, this, [this]() {
+            chooseTripShape();
+        });
+        contextMenu.addAction(shapeAction);
+    }
+    QAction* nearbyAction = new QAction("Campuses Near " + college, &contextMenu);
+    connect(nearbyAction, &QAction::triggered, this, [this, college]() {
+        showCampusesNear(college);
     });
-    contextMenu.addAction(toggleHighlightAction);
-    contextMenu.exec(ui->listWidgetDistances->mapToGlobal(pos));
+    contextMenu.addAction(nearbyAction);
+    contextMenu.exec(ui->listViewDistances->mapToGlobal(pos));
 }
 
-void MainWindow::toggleItemHighlight(QListWidgetItem* item) {
-    QColor currentColor = item->background().color();
-    if (currentColor == QColor(Qt::blue)) {
-        item->setBackground(Qt::white);  // Unhighlight the item
-    } else {
-        item->setBackground(Qt::blue);  // Highlight the item
+void MainWindow::showCampusesNear(const QString &college) {
+    bool ok = false;
+    double miles = QInputDialog::getDouble(this, "Campuses Near " + college,
+                                           "Show campuses within this many miles (straight line):",
+                                           100, 1, 5000, 0, &ok);
+    if (!ok)
+        return;
+
+    // Straight-line distances from the campus locations, answered by the snapshot's k-d tree.
+    std::shared_ptr<const DistanceGraph> graph = graphStore.current();
+    const CampusSpatialIndex &index = graph->spatialIndex();
+    std::vector<std::pair<QString, double>> found = index.withinRadius(college, miles);
+    QString heading = QString("Campuses within %1 miles of %2:").arg(miles).arg(college);
+    if (found.empty()) {
+        // Nothing that close; show the closest few instead.
+        found = index.nearest(college, 5);
+        heading = QString("No campuses within %1 miles of %2. The closest are:").arg(miles).arg(college);
     }
+    if (found.empty()) {
+        QMessageBox::information(this, "Campuses Near " + college,
+                                 "No location is recorded for " + college + ".");
+        return;
+    }
+
+    QStringList lines;
+    lines << heading;
+    for (const auto &campus : found)
+        lines << QString("%1 - %2 miles").arg(campus.first).arg(campus.second, 0, 'f', 0);
+    QMessageBox::information(this, "Campuses Near " + college, lines.join("\n"));
 }
 
-void MainWindow::updateDistanceList(const QString &selectedCollege) {
-    ui->listWidgetDistances->clear();
+void MainWindow::toggleItemHighlight(int row) {
+    campusModel->toggleSelected(row);
+}
 
-    // Add the starting college at the top.
-    QListWidgetItem *referenceItem = new QListWidgetItem(selectedCollege + " - (Start)");
-    referenceItem->setData(Qt::UserRole, "reference");
-    referenceItem->setFlags(referenceItem->flags() & ~Qt::ItemIsSelectable);
-    ui->listWidgetDistances->addItem(referenceItem);
+void MainWindow::updateDistanceList(const QString &selectedCollege) {
+    // One query for every distance from the start instead of one per college.
+    QHash<QString, double> distanceTo;
+    for (const auto &p : dbManager->getDistances(selectedCollege))
+        distanceTo[p.first] = p.second;
 
     // Retrieve all colleges from the database.
     std::vector<QString> allColleges = dbManager->getColleges();
+    std::vector<std::pair<QString, double>> others;
+    others.reserve(allColleges.size());
     for (const QString &college : allColleges) {
         if (college == selectedCollege)
             continue;  
-        double distance = dbManager->getDistance(selectedCollege, college);
-        QString displayText = QString("%1 - %2 miles").arg(college).arg(distance);
-        QListWidgetItem *item = new QListWidgetItem(displayText);
-        ui->listWidgetDistances->addItem(item);
+        double distance = distanceTo.value(college, std::numeric_limits<double>::max());
+        others.emplace_back(college, distance);
     }
+    campusModel->showDistances(selectedCollege, others);
 }
 
 
-void MainWindow::onDistanceItemClicked(QListWidgetItem *item) {
+void MainWindow::onDistanceItemClicked(const QModelIndex &index) {
+    QString collegeName = campusModel->collegeAt(index.row());
+    // While a trip is shown, its rows are the stops in route order.
+    int row = index.row();
+    bool tripStop = session.isActive() && row < session.stopCount() && session.stop(row) == collegeName;
     if (listLocked) {
         // If the list is locked, check if the item is highlighted
-        if (item->background() == QColor(Qt::blue)) {
-            // Extract the college name from the clicked item
-            QString collegeName = item->text().section(" -", 0, 0).trimmed();
+        if (campusModel->isSelected(index.row())) {
             // Show souvenirs for the clicked college
-            updateSouvenirList(collegeName);
+            if (tripStop)
+                showStopSouvenirs(row);
+            else
+                updateSouvenirList(collegeName);
         } else {
             // If the item is not highlighted, do nothing or show a message
             QMessageBox::information(this, "Item Locked", "Only highlighted colleges are clickable.");
         }
     } else {
         // Normal behavior for unlocked items
-        QString collegeName = item->text().section(" -", 0, 0).trimmed();
-        updateSouvenirList(collegeName);
+        if (tripStop)
+            showStopSouvenirs(row);
+        else
+            updateSouvenirList(collegeName);
     }
 }
 
 void MainWindow::updateSouvenirList(const QString &college) {
-    std::vector<std::pair<QString, double>> souvenirs = dbManager->getSouvenirs(college);
-    
+    showSouvenirs(dbManager->getSouvenirs(college));
+}
+
+void MainWindow::showStopSouvenirs(int position) {
+    if (stopSouvenirsReady && position >= 0 && position < static_cast<int>(stopSouvenirs.size())) {
+        showSouvenirs(stopSouvenirs[position]);
+        return;
+    }
+    // The prefetch has not landed yet; ask the database directly.
+    updateSouvenirList(session.stop(position));
+}
+
+void MainWindow::prefetchSouvenirs() {
+    // Any fetch still in flight is for an older route; its results will be dropped.
+    quint64 generation = ++souvenirGeneration;
+    stopSouvenirs.clear();
+    stopSouvenirsReady = false;
+    if (!session.isActive())
+        return;
+
+    // An older fetch is left to finish on its own rather than waited for here.
+    std::vector<QString> route = session.route();
+    DatabaseManager *db = dbManager;
+    QThread *prefetch = QThread::create([this, db, route, generation]() {
+        // One batched query on this thread's own connection.
+        std::vector<std::vector<std::pair<QString, double>>> catalogs = db->getSouvenirCatalogs(route);
+        db->releaseThreadConnection();
+        QMetaObject::invokeMethod(this, [this, generation, catalogs = std::move(catalogs)]() mutable {
+            onSouvenirsPrefetched(generation, std::move(catalogs));
+        }, Qt::QueuedConnection);
+    });
+    souvenirPrefetches.insert(prefetch);
+    connect(prefetch, &QThread::finished, this, [this, prefetch]() {
+        souvenirPrefetches.erase(prefetch);
+        prefetch->deleteLater();
+    });
+    prefetch->start();
+}
+
+void MainWindow::onSouvenirsPrefetched(quint64 generation,
+                                       std::vector<std::vector<std::pair<QString, double>>> catalogs) {
+    if (generation != souvenirGeneration)
+        return;
+    stopSouvenirs = std::move(catalogs);
+    stopSouvenirsReady = true;
+}
+
+void MainWindow::showSouvenirs(const std::vector<std::pair<QString, double>> &souvenirs) {
     qDebug() << "Souvenirs retrieved: " << souvenirs.size();
     ui->listWidgetSouvenirs->clear();
     
@@ -173,70 +354,74 @@ void MainWindow::updateSouvenirList(const QString &college) {
 }
 
 void MainWindow::onNextButtonClicked() {
-    static int currentIndex = -1;
-    QList<QListWidgetItem*> highlightedItems;
-
-    for (int i = 0; i < ui->listWidgetDistances->count(); ++i) {
-        QListWidgetItem* item = ui->listWidgetDistances->item(i);
-        if (item->background() == QColor(Qt::blue))
-            highlightedItems.append(item);
-    }
-
-    if (highlightedItems.isEmpty()) {
-        QMessageBox::information(this, "No Highlights", "No highlighted colleges found.");
+    if (!session.isActive()) {
+        QMessageBox::information(this, "No Trip", "Plan a trip before moving to the next college.");
         return;
     }
 
-    // If at the end, finalize current college, update display, then reset trip.
-    if (currentIndex >= highlightedItems.size() - 1) {
-        QString currentCollege = highlightedItems[currentIndex]->text().section(" -", 0, 0).trimmed();
-        if (!visitedColleges.contains(currentCollege))
-            visitedColleges.append(currentCollege);
-        updatePurchasedSouvenirsDisplay();
-        currentIndex = -1;
+    int finishedStop = session.cursor();
+    if (finishedStop >= 0 && !session.isVisited(finishedStop))
+        ledger->addCollege(session.stop(finishedStop));
+
+    // If at the end, finalize current college, then reset trip.
+    if (session.advance() == TripSession::Finished) {
         onUnlockButtonClicked();
         return;
-    } else {
-        if (currentIndex >= 0) {
-            QString currentCollege = highlightedItems[currentIndex]->text().section(" -", 0, 0).trimmed();
-            if (!visitedColleges.contains(currentCollege))
-                visitedColleges.append(currentCollege);
-        }
-        currentIndex++;
     }
 
-    ui->listWidgetDistances->setCurrentItem(highlightedItems[currentIndex]);
-    QString selectedCollege = highlightedItems[currentIndex]->text().section(" -", 0, 0).trimmed();
-    updateSouvenirList(selectedCollege);
-    updatePurchasedSouvenirsDisplay();
+    // In a planned trip the stops are the rows of the list, in order.
+    int row = session.cursor();
+    campusModel->ensureLoaded(row);
+    ui->listViewDistances->setCurrentIndex(campusModel->index(row));
+    showStopSouvenirs(row);
+    saveSession();
+}
+
+void MainWindow::saveSession() {
+    if (session.isActive())
+        session.save(TripSessionFile);
+}
+
+void MainWindow::restoreSession() {
+    if (!session.load(TripSessionFile))
+        return;
+
+    campusModel->showTrip(session.route(), session.legs(), session.estimatedLegs());
+    prefetchSouvenirs();
+    showTotalDistance();
+
+    ledger->clear();
+    for (int i = 0; i < session.stopCount(); i++) {
+        if (session.isVisited(i))
+            ledger->addCollege(session.stop(i));
+    }
+    for (const PurchasedSouvenir &ps : session.purchases())
+        ledger->addPurchase(ps);
+    saveSession();
+
+    int row = std::max(session.cursor(), 0);
+    campusModel->ensureLoaded(row);
+    ui->listViewDistances->setCurrentIndex(campusModel->index(row));
+    showStopSouvenirs(row);
+    updateTripControls();
+    ui->statusbar->showMessage("Resumed trip in progress.", 3000);
 }
 
 
 void MainWindow::onLockButtonClicked() {
     // Clear souvenir display.
-    ui->listWidgetPurchasedSouvenirs->clear();
-    visitedColleges.clear();
-    purchases.clear();
+    ledger->clear();
 
     // Get the reference college from the dropdown.
-    QString startingCollege = ui->comboBoxColleges->currentText();
+    QString startingCollege = selectedCollege();
 
     // Gather the highlighted colleges (skip the reference item if it exists).
     std::vector<QString> selectedColleges;
     selectedColleges.push_back(startingCollege);  // Ensure starting college is first
 
-    // Iterate over all items (after the reference) and add highlighted items.
-    for (int i = 0; i < ui->listWidgetDistances->count(); i++) {
-        QListWidgetItem* item = ui->listWidgetDistances->item(i);
-        // Skip the reference college if it’s marked.
-        if (item->data(Qt::UserRole).toString() == "reference")
-            continue;
-        if (item->background() == QColor(Qt::blue)) {
-            // When planning the trip, use only the college name (strip any extra info).
-            QString collegeName = item->text().section(" -", 0, 0).trimmed();
-            selectedColleges.push_back(collegeName);
-        }
-    }
+    // Add every highlighted college after the reference.
+    std::vector<QString> highlighted = campusModel->selectedColleges();
+    selectedColleges.insert(selectedColleges.end(), highlighted.begin(), highlighted.end());
 
     if (selectedColleges.size() < 2) {
         QMessageBox::information(this, "Insufficient Selection",
@@ -244,77 +429,299 @@ void MainWindow::onLockButtonClicked() {
         return;
     }
 
-    // Calculate the trip based on the selected (highlighted) colleges.
+    // Calculate the trip based on the selected (highlighted) colleges, against one
+    // consistent snapshot of the distances and campus locations.
+    std::shared_ptr<const DistanceGraph> graph = graphStore.current();
+    std::unique_ptr<TripPlanner> planner = std::make_unique<TripPlanner>();
+    planner->calculateTrip(selectedColleges, *graph);
+    showShapeableTrip(std::move(planner));
+}
+
+void MainWindow::onAutoTourButtonClicked() {
+    QString startingCollege = selectedCollege();
+    // Plan against one consistent snapshot even if an import publishes a new one meanwhile.
+    std::shared_ptr<const DistanceGraph> graph = graphStore.current();
+    int start = graph->idOf(startingCollege);
+    if (start < 0 || graph->size() < 2) {
+        QMessageBox::information(this, "Auto Tour", "No distances are known for the selected college.");
+        return;
+    }
+
+    bool ok = false;
+    int maxCount = graph->size() - 1;
+    int count = QInputDialog::getInt(this,
+                                     "Auto Tour",
+                                     "Number of closest campuses to visit:",
+                                     std::min(5, maxCount), // default value
+                                     1,                     // minimum value
+                                     maxCount,              // maximum value
+                                     1,                     // step
+                                     &ok);
+    if (!ok)
+        return;
+
+    // Pick the closest reachable campuses, then plan the order to visit them in.
+    std::vector<QString> selectedColleges;
+    selectedColleges.push_back(startingCollege);
+    for (int id : graph->nearestReachable(start, count))
+        selectedColleges.push_back(graph->name(id));
+
+    if (selectedColleges.size() < 2) {
+        QMessageBox::information(this, "Auto Tour", "No other campuses can be reached from the selected college.");
+        return;
+    }
+
+    ledger->clear();
+    std::unique_ptr<TripPlanner> planner = std::make_unique<TripPlanner>();
+    planner->calculateTrip(selectedColleges, *graph);
+    showShapeableTrip(std::move(planner));
+}
+
+void MainWindow::onBudgetTourButtonClicked() {
+    QString startingCollege = selectedCollege();
+    // Plan against one consistent snapshot even if an import publishes a new one meanwhile.
+    std::shared_ptr<const DistanceGraph> graph = graphStore.current();
+    if (graph->idOf(startingCollege) < 0) {
+        QMessageBox::information(this, "Budget Tour", "No distances are known for the selected college.");
+        return;
+    }
+
+    bool ok = false;
+    double maxMiles = QInputDialog::getDouble(this,
+                                              "Budget Tour",
+                                              "Maximum miles to drive:",
+                                              1000, 0, 100000, 0,
+                                              &ok);
+    if (!ok)
+        return;
+
+    // Candidates are the highlighted colleges, or every college if none are highlighted.
+    std::vector<QString> candidates;
+    candidates.push_back(startingCollege);
+    std::vector<QString> highlighted = campusModel->selectedColleges();
+    if (highlighted.empty()) {
+        for (int id = 0; id < graph->size(); id++) {
+            if (graph->name(id) != startingCollege)
+                candidates.push_back(graph->name(id));
+        }
+    } else {
+        candidates.insert(candidates.end(), highlighted.begin(), highlighted.end());
+    }
+
+    // Highlighted campuses can be given priorities; the tour then collects the most
+    // priority points instead of simply visiting the most campuses.
+    std::vector<double> scores;
+    if (!highlighted.empty()) {
+        QMessageBox::StandardButton weigh = QMessageBox::question(this,
+                                        "Budget Tour",
+                                        "Give the highlighted campuses different priorities?\n"
+                                        "No visits as many of them as possible.",
+                                        QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+        if (weigh == QMessageBox::Cancel)
+            return;
+        if (weigh == QMessageBox::Yes) {
+            // The start is always visited, so it adds nothing to the comparison.
+            scores.assign(candidates.size(), 0.0);
+            for (size_t i = 1; i < candidates.size(); i++) {
+                scores[i] = QInputDialog::getDouble(this,
+                                                    "Budget Tour",
+                                                    "Priority of " + candidates[i] + ":",
+                                                    1, 0, 1000, 1,
+                                                    &ok);
+                if (!ok)
+                    return;
+            }
+        }
+    }
+
+    ledger->clear();
     TripPlanner planner;
-    planner.calculateTrip(selectedColleges, dbManager);
-    double totalDistance = planner.getTotalDistance();
-    std::vector<QString> tripPath = planner.getPath();
+    planner.calculateBudgetTrip(candidates, scores, maxMiles, *graph);
+    if (planner.getPath().size() < 2) {
+        QMessageBox::information(this, "Budget Tour", "No other campus can be reached within that budget.");
+        return;
+    }
+    showPlannedTrip(planner);
+    QString summary = QString("Budget tour visits %1 of %2 campuses using %3 of %4 miles.")
+                          .arg(planner.getPath().size())
+                          .arg(candidates.size())
+                          .arg(planner.getTotalDistance())
+                          .arg(maxMiles);
+    if (!scores.empty())
+        summary += QString(" Priority collected: %1.").arg(planner.getTotalScore());
+    ui->statusbar->showMessage(summary, 5000);
+}
 
-    // Now update the list to show only the planned trip order.
-    ui->listWidgetDistances->clear();
+void MainWindow::showShapeableTrip(std::unique_ptr<TripPlanner> planner) {
+    showPlannedTrip(*planner);
+    shapePlanner = std::move(planner);
+    ui->statusbar->showMessage("Right-click the trip to make it a round trip or end it elsewhere.", 5000);
+}
 
-    double summedDistance = 0.0;
-    if (!tripPath.empty()) {
-        // Display the starting college as the first item.
-        QListWidgetItem *startItem = new QListWidgetItem(tripPath[0] + " - (Start, 0 miles)");
-        // Mark it as reference by storing a custom role.
-        startItem->setData(Qt::UserRole, "reference");
-        startItem->setBackground(Qt::blue);
-        ui->listWidgetDistances->addItem(startItem);
+void MainWindow::chooseTripShape() {
+    // Only before the trip gets under way: the session is replaced by the new shape.
+    if (!shapePlanner || session.cursor() >= 0 || !session.purchases().empty())
+        return;
+    TripPlanner &planner = *shapePlanner;
+    // One solve gives the open trip, the round trip and the best trip to every
+    // endpoint, so let the user pick without planning again.
+    const std::vector<QString> stops = planner.getPath();
+    if (stops.size() < 2)
+        return;
+    const double unknown = std::numeric_limits<double>::infinity();
+
+    QStringList options;
+    std::vector<QString> endings;   // Empty for the current trip, the start for the round trip.
+    options << QString("Keep the current trip (%1 miles)").arg(planner.getTotalDistance());
+    endings.push_back(QString());
+    if (planner.getRoundTripDistance() != unknown) {
+        options << QString("Round trip back to %1 (%2 miles)").arg(stops[0]).arg(planner.getRoundTripDistance());
+        endings.push_back(stops[0]);
     }
-    
-    // For each subsequent college, calculate the leg distance and display it.
-    for (size_t i = 1; i < tripPath.size(); i++) {
-        QString prev = tripPath[i - 1];
-        QString curr = tripPath[i];
-        double legDistance = dbManager->getDistance(prev, curr);
-        summedDistance += legDistance;
-        QString itemText = QString("%1 - %2 miles").arg(curr).arg(legDistance);
-        QListWidgetItem *item = new QListWidgetItem(itemText);
-        item->setBackground(Qt::blue);
-        ui->listWidgetDistances->addItem(item);
+    for (size_t i = 1; i < stops.size(); i++) {
+        if (stops[i] == stops[0])
+            continue;
+        double miles = planner.getDistanceEndingAt(stops[i]);
+        if (miles == unknown)
+            continue;
+        options << QString("End at %1 (%2 miles)").arg(stops[i]).arg(miles);
+        endings.push_back(stops[i]);
     }
+    if (options.size() < 2)
+        return;
 
-    ui->labelTotalDistance->setText(QString("Total Distance: %1 miles").arg(summedDistance));
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Trip Shape", "How should the trip end?", options, 0, false, &ok);
+    int picked = ok ? options.indexOf(choice) : 0;
+    if (picked <= 0)
+        return;
+    bool changed = endings[picked] == stops[0] ? planner.useRoundTrip() : planner.useEndingAt(endings[picked]);
+    if (changed) {
+        std::unique_ptr<TripPlanner> reshaped = std::move(shapePlanner);
+        showPlannedTrip(*reshaped);
+        shapePlanner = std::move(reshaped);
+    }
+}
 
-    QMessageBox::information(this, "Trip Planned", "Trip planned successfully.");
+void MainWindow::showPlannedTrip(TripPlanner &planner) {
+    shapePlanner.reset();
+    plannedGraphVersion = planner.getGraphVersion();
+    const std::vector<QString> &tripPath = planner.getPath();
+
+    // Now update the list to show only the planned trip order.
+    // For each college after the start, take the leg distance from the planner.
+    const std::vector<double> &legs = planner.getLegDistances();
+    campusModel->showTrip(tripPath, legs, planner.getEstimatedLegs());
+    session.start(tripPath, legs, planner.getEstimatedLegs());
+    saveSession();
+    prefetchSouvenirs();
+    updateTripControls();
+
+    showTotalDistance();
+
+    QString message = "Trip planned successfully.";
+    if (planner.getApproximation() == TripPlanner::TooManyColleges) {
+        message += "\nThis trip has too many campuses to solve exactly, so it was planned with a "
+                   "fast approximation and may not be the best possible.";
+    } else if (planner.getApproximation() == TripPlanner::MissingDistances) {
+        // Name the legs that have no distance, recorded or estimated.
+        QStringList missing;
+        for (size_t i = 1; i < tripPath.size(); i++) {
+            if (legs[i] >= std::numeric_limits<double>::max() / 2)
+                missing << tripPath[i - 1] + " to " + tripPath[i];
+        }
+        message += "\nNo order of these campuses avoids a pair with no recorded distance and no location "
+                   "to estimate one, so the trip was planned with a fast approximation. "
+                   "These legs have no known distance:\n" + missing.join("\n");
+    }
+    QMessageBox::information(this, "Trip Planned", message);
 
     // Update the souvenirs for the starting college.
-    if (ui->listWidgetDistances->count() > 0) {
-        QListWidgetItem* firstItem = ui->listWidgetDistances->item(0);
-        ui->listWidgetDistances->setCurrentItem(firstItem);
-        QString collegeName = firstItem->text().section(" -", 0, 0).trimmed();
-        updateSouvenirList(collegeName);
+    if (campusModel->entryCount() > 0) {
+        ui->listViewDistances->setCurrentIndex(campusModel->index(0));
+        showStopSouvenirs(0);
     }
 }
 
 
+void MainWindow::showTotalDistance() {
+    QString text = QString("Total Distance: %1 miles").arg(session.totalDistance());
+    // Legs filled in from campus coordinates are only approximate.
+    if (session.hasEstimates())
+        text += " (includes estimates)";
+    ui->labelTotalDistance->setText(text);
+}
+
 void MainWindow::onUnlockButtonClicked() {
     listLocked = false;
-    ui->listWidgetDistances->setEnabled(true);
-    updateDistanceList(ui->comboBoxColleges->currentText());
+    ui->listViewDistances->setEnabled(true);
+    updateDistanceList(selectedCollege());
     ui->labelTotalDistance->setText("Total Distance: 0 miles");
     
-    visitedColleges.clear();
-    purchases.clear();
+    session.clear();
+    shapePlanner.reset();
+    prefetchSouvenirs();
+    TripSession::remove(TripSessionFile);
+    updateTripControls();
 
     QMessageBox::information(this, "List Unlocked", "You can now select and modify items.");
 }
 
+void MainWindow::rebuildDistanceGraph() {
+    // Build the next snapshot on the side; readers keep the old one until they are done.
+    DistanceGraph next;
+    next.build(dbManager->getAllDistances(), dbManager->getCoordinates());
+    graphStore.publish(std::move(next));
+    if (session.isActive() && plannedGraphVersion != graphStore.version())
+        ui->statusbar->showMessage("Distances changed since this trip was planned.", 3000);
+}
+
 void MainWindow::on_importButton_clicked() {
+    // Importing refreshes the college list, which would replace the trip being toured.
+    if (session.isActive()) {
+        QMessageBox::information(this, "Trip In Progress",
+                                 "Unlock or finish the current trip before importing new campuses.");
+        return;
+    }
+
     // Construct the full path to newcampuses.csv in the executable's directory.
     QString appDir = QCoreApplication::applicationDirPath();
     QString csvFile = appDir + "/newcampuses.csv";
     
     if (dbManager->importNewCampuses(csvFile)) {
+        // Pick up locations for the new campuses, if the coordinates file lists them.
+        dbManager->importCoordinates(appDir + "/campuscoordinates.csv");
+        rebuildDistanceGraph();
         ui->statusbar->showMessage("New campuses imported successfully.", 3000);
         // Refresh the college combo box to include any newly imported campuses (starts with first college in list selected).
         updateCollegeComboBox();
+        reportImportIssues(true);
     } else {
         ui->statusbar->showMessage("Failed to import new campuses.", 3000);
     }
 }
 
+void MainWindow::reportImportIssues(bool showDialog) {
+    QStringList issues = dbManager->takeImportIssues();
+    if (issues.isEmpty())
+        return;
+    for (const QString &issue : issues)
+        qDebug() << "Import issue:" << issue;
+    // The bundled files are re-imported at every startup, so their issues would
+    // come back every launch; those only go to the log.
+    if (!showDialog)
+        return;
+
+    QString summary = QString("%1 distance(s) disagree between directions; the first value was kept.")
+                          .arg(issues.size());
+    // List the first few; the log has all of them.
+    const int shown = 10;
+    QStringList lines = issues.mid(0, shown);
+    if (issues.size() > shown)
+        lines << QString("...and %1 more (see the log).").arg(issues.size() - shown);
+    QMessageBox::warning(this, "Import Validation", summary + "\n\n" + lines.join("\n"));
+}
+
 void MainWindow::onSouvenirDoubleClicked(QListWidgetItem *item) {
     // Parse the item text "SouvenirName - $Price"
     QString text = item->text();
@@ -336,8 +743,10 @@ void MainWindow::onSouvenirDoubleClicked(QListWidgetItem *item) {
         return;
     }
 
-    QString college = ui->listWidgetDistances->currentItem()->text();
-    college = college.section(" -", 0, 0).trimmed();
+    QModelIndex current = ui->listViewDistances->currentIndex();
+    if (!current.isValid())
+        return;
+    QString college = campusModel->collegeAt(current.row());
 
     // Create a purchase record with quantity.
     PurchasedSouvenir ps;
@@ -345,37 +754,11 @@ void MainWindow::onSouvenirDoubleClicked(QListWidgetItem *item) {
     ps.souvenirName = name;
     ps.price = price;
     ps.quantity = quantity;
-    purchases.push_back(ps);
-
-    updatePurchasedSouvenirsDisplay();
-}
-
-void MainWindow::updatePurchasedSouvenirsDisplay() {
-    ui->listWidgetPurchasedSouvenirs->clear();
-    double grandTotal = 0.0;
-
-    // For each visited college (tracked in visitedColleges)
-    for (const QString &college : visitedColleges) {
-        double collegeTotal = 0.0;
-        // Iterate over purchases for this college.
-        for (const PurchasedSouvenir &ps : purchases) {
-            if (ps.college == college) {
-                double totalCost = ps.price * ps.quantity;
-                QString line = QString("%1: %2 x %3 = $%4")
-                                   .arg(college)
-                                   .arg(ps.souvenirName)
-                                   .arg(ps.quantity)
-                                   .arg(totalCost, 0, 'f', 2);
-                ui->listWidgetPurchasedSouvenirs->addItem(line);
-                collegeTotal += totalCost;
-            }
-        }
-        ui->listWidgetPurchasedSouvenirs->addItem(
-            QString("Total for %1: $%2").arg(college).arg(collegeTotal, 0, 'f', 2));
-        grandTotal += collegeTotal;
-    }
-    ui->listWidgetPurchasedSouvenirs->addItem(
-        QString("Grand Total: $%1").arg(grandTotal, 0, 'f', 2));
+    ledger->addPurchase(ps);
+    session.addPurchase(ps);
+    // Only the new purchase is written; the session file is rewritten on the next step.
+    if (session.isActive())
+        session.journalPurchase(TripSessionFile, ps);
 }
 
 void MainWindow::onMaintenanceButtonClicked() {
@@ -409,6 +792,7 @@ void MainWindow::onMaintenanceButtonClicked() {
             << "Edit Souvenir price"
             << "Add Souvenir"
             << "Delete Souvenir"
+            << "Sync Souvenir Catalog"
             << "Drop Tables";
     QString selection = QInputDialog::getItem(this,
                                               "Select Modification",
@@ -427,14 +811,10 @@ void MainWindow::onMaintenanceButtonClicked() {
     }
     else if (selection == "Edit Souvenir price") {
         // Prompt for the college name.
-        QString college = QInputDialog::getText(this,
-                                                "Edit Souvenir Price",
-                                                "Enter college name:");
+        QString college = promptForName("Edit Souvenir Price", "Enter college name:", &collegeNames);
         if (college.isEmpty()) return;
         
-        QString souvenir = QInputDialog::getText(this,
-                                                 "Edit Souvenir Price",
-                                                 "Enter souvenir name:");
+        QString souvenir = promptForName("Edit Souvenir Price", "Enter souvenir name:", &souvenirNames);
         if (souvenir.isEmpty()) return;
         
         double newPrice = QInputDialog::getDouble(this,
@@ -444,20 +824,18 @@ void MainWindow::onMaintenanceButtonClicked() {
                                                   &ok);
         if (!ok) return;
         
-        if (dbManager->updateSouvenirPrice(souvenir, newPrice))
+        if (dbManager->updateSouvenirPrice(college, souvenir, newPrice)) {
+            prefetchSouvenirs();
             QMessageBox::information(this, "Success", "Souvenir price updated successfully.");
+        }
         else
             QMessageBox::warning(this, "Failure", "Failed to update souvenir price.");
     }
     else if (selection == "Add Souvenir") {
-        QString college = QInputDialog::getText(this,
-                                                "Add Souvenir",
-                                                "Enter college name:");
+        QString college = promptForName("Add Souvenir", "Enter college name:", &collegeNames);
         if (college.isEmpty()) return;
         
-        QString souvenir = QInputDialog::getText(this,
-                                                 "Add Souvenir",
-                                                 "Enter souvenir name:");
+        QString souvenir = promptForName("Add Souvenir", "Enter souvenir name:", &souvenirNames);
         if (souvenir.isEmpty()) return;
         
         double price = QInputDialog::getDouble(this,
@@ -467,27 +845,79 @@ void MainWindow::onMaintenanceButtonClicked() {
                                                &ok);
         if (!ok) return;
         
-        if (dbManager->addSouvenir(college, souvenir, price))
+        if (dbManager->addSouvenir(college, souvenir, price)) {
+            souvenirNames.insert(souvenir);
+            prefetchSouvenirs();
             QMessageBox::information(this, "Success", "Souvenir added successfully.");
+        }
         else
             QMessageBox::warning(this, "Failure", "Failed to add souvenir.");
     }
     else if (selection == "Delete Souvenir") {
-        QString college = QInputDialog::getText(this,
-                                                "Delete Souvenir",
-                                                "Enter college name:");
+        QString college = promptForName("Delete Souvenir", "Enter college name:", &collegeNames);
         if (college.isEmpty()) return;
         
-        QString souvenir = QInputDialog::getText(this,
-                                                 "Delete Souvenir",
-                                                 "Enter souvenir name:");
+        QString souvenir = promptForName("Delete Souvenir", "Enter souvenir name:", &souvenirNames);
         if (souvenir.isEmpty()) return;
         
-        if (dbManager->removeSouvenir(souvenir))
+        if (dbManager->removeSouvenir(college, souvenir)) {
+            souvenirNames.remove(souvenir);
+            prefetchSouvenirs();
             QMessageBox::information(this, "Success", "Souvenir deleted successfully.");
+        }
         else
             QMessageBox::warning(this, "Failure", "Failed to delete souvenir.");
     }
+    else if (selection == "Sync Souvenir Catalog") {
+        QString file = QFileDialog::getOpenFileName(this,
+                                                    "Sync Souvenir Catalog",
+                                                    QCoreApplication::applicationDirPath(),
+                                                    "CSV files (*.csv);;All files (*)");
+        if (file.isEmpty()) return;
+
+        QMessageBox::StandardButton removeReply = QMessageBox::question(this,
+                                        "Sync Souvenir Catalog",
+                                        "Is this the complete catalog?\n"
+                                        "Yes removes souvenirs the file does not list; No only adds and reprices.",
+                                        QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+        if (removeReply == QMessageBox::Cancel) return;
+
+        QElapsedTimer timer;
+        timer.start();
+        CatalogSyncResult result = dbManager->syncSouvenirCatalog(file, removeReply == QMessageBox::Yes,
+            [this, &timer](const CatalogSyncResult &planned) {
+                if (planned.removed == 0)
+                    return true;
+                bool proceed = QMessageBox::question(this, "Sync Souvenir Catalog",
+                                                     QString("This will remove %1 souvenir(s) the file does not list, "
+                                                             "add %2 and reprice %3. Continue?")
+                                                         .arg(planned.removed)
+                                                         .arg(planned.added)
+                                                         .arg(planned.updated),
+                                                     QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+                // Time the sync, not the question.
+                timer.restart();
+                return proceed;
+            });
+        if (!result.ok) {
+            if (result.problem.isEmpty())
+                QMessageBox::warning(this, "Failure", "Failed to sync the souvenir catalog; nothing was changed.");
+            else
+                QMessageBox::warning(this, "Catalog Not Synced", result.problem + "\nNothing was changed.");
+            return;
+        }
+        souvenirNames.assign(dbManager->getSouvenirNames());
+        prefetchSouvenirs();
+        QMessageBox::information(this, "Catalog Synced",
+                                 QString("Added: %1\nUpdated: %2\nRemoved: %3\nUnchanged: %4\nSkipped lines: %5\n"
+                                         "Took %6 s.")
+                                     .arg(result.added)
+                                     .arg(result.updated)
+                                     .arg(result.removed)
+                                     .arg(result.unchanged)
+                                     .arg(result.skipped)
+                                     .arg(timer.elapsed() / 1000.0, 0, 'f', 2));
+    }
     else if (selection == "Drop Tables") {
         QMessageBox::StandardButton confirm = QMessageBox::question(this,
                                         "Confirm Drop",
@@ -495,6 +925,10 @@ void MainWindow::onMaintenanceButtonClicked() {
                                         QMessageBox::Yes | QMessageBox::No);
         if (confirm == QMessageBox::Yes) {
             dbManager->dropTables();
+            collegeNames.clear();
+            souvenirNames.clear();
+            rebuildDistanceGraph();
+            prefetchSouvenirs();
             QMessageBox::information(this, "Success", "Tables dropped successfully.");
         } else {
             QMessageBox::information(this, "Cancelled", "Table drop cancelled.");
@@ -11,7 +11,19 @@
 #include <limits>
 #include <algorithm>
 #include <unordered_set>
+#include <memory>
 #include "DatabaseManager.h"
+#include "PurchaseLedger.h"
+#include "CampusListModel.h"
+#include "TripSession.h"
+#include "DistanceGraph.h"
+#include "NameIndex.h"
+
+class QLineEdit;
+class QCompleter;
+class QThread;
+
+class TripPlanner;
 
 struct Purchase {
     QString college;
@@ -19,13 +31,6 @@ struct Purchase {
     double price;
 };
 
-struct PurchasedSouvenir {
-    QString college;
-    QString souvenirName;
-    double price;
-    int quantity;
-};
-
 namespace Ui {
 class MainWindow;
 }
@@ -40,44 +45,98 @@ public:
 private slots:
     // When the combo box selection changes, update the list of distances.
     void onCollegeChanged(const QString &college);
-    // When a list item is clicked, toggle its background color.
-    void onDistanceItemClicked(QListWidgetItem *item);
+    // When a list item is clicked, show the souvenirs of that college.
+    void onDistanceItemClicked(const QModelIndex &index);
 
     void updateSouvenirList(const QString &college);
     
     // When the lock button is pressed, disable further clicking.
     void onLockButtonClicked();
+    // Plans a trip to the N campuses closest to the selected college.
+    void onAutoTourButtonClicked();
+    // Plans the most campuses that fit within a driving budget.
+    void onBudgetTourButtonClicked();
     void onUnlockButtonClicked();
     void onNextButtonClicked();
     // Imports new colleges
     void on_importButton_clicked();
 
     void onSouvenirDoubleClicked(QListWidgetItem *item);
-    
-    void updatePurchasedSouvenirsDisplay();
 
     void onMaintenanceButtonClicked();
 
 
 private:
-    QVector<PurchasedSouvenir> purchases;
-    QStringList visitedColleges;
+    // Route, position, visited stops and purchases of the trip in progress
+    TripSession session;
+    // Versioned snapshots of the Distances table and campus locations for planning
+    DistanceGraphStore graphStore;
+    // Souvenirs of every stop of the trip, by route position, fetched in the background
+    std::vector<std::vector<std::pair<QString, double>>> stopSouvenirs;
+    bool stopSouvenirsReady = false;
+    // Bumped whenever the route changes so results of an older prefetch are dropped
+    quint64 souvenirGeneration = 0;
+    // Prefetch threads not yet finished; each deletes itself when done
+    std::unordered_set<QThread *> souvenirPrefetches;
+    // Planner of the trip on screen while its ending can still be changed; null otherwise
+    std::unique_ptr<TripPlanner> shapePlanner;
+    // Type-ahead indexes over campus and souvenir names
+    NameIndex collegeNames;
+    NameIndex souvenirNames;
+    // Snapshot version the current trip was planned against
+    quint64 plannedGraphVersion = 0;
     // Log of all purchases made during the trip
     std::vector<Purchase> purchaseLog;
-    // Grand total of souvenirs purchased across all colleges
-    double grandTotal = 0.0;
+    // Purchases grouped by college with running college and grand totals
+    PurchaseLedger *ledger;
+    // College ids and highlight state behind listViewDistances
+    CampusListModel *campusModel;
     // The currently selected college (updated when a souvenir list is shown)
     QString currentCollege;
     Ui::MainWindow *ui;
     DatabaseManager *dbManager;
     bool listLocked;
     void onListWidgetContextMenuRequested(const QPoint &pos);
-    void toggleItemHighlight(QListWidgetItem* item);
+    void toggleItemHighlight(int row);
+    // Lists the campuses within a chosen straight-line radius of a campus.
+    void showCampusesNear(const QString &college);
     std::vector<QString> highlightedCollegeNames;
-    int currentIndex = 0; // To keep track of the current college being displayed
     void unlockList();
+    // Enables the controls that would rebuild the list only while no trip is in progress.
+    void updateTripControls();
     void updateCollegeComboBox();
+    // College selected in the combo box (not any text still being typed into it).
+    QString selectedCollege() const;
+    // Shows matches from the index in a popup while the user types into the line edit;
+    // returns the completer so callers can react to a match being picked.
+    QCompleter *attachNameCompleter(QLineEdit *edit, const NameIndex *index);
+    // Asks for a name with type-ahead from the index; returns an empty string if cancelled.
+    QString promptForName(const QString &title, const QString &label, const NameIndex *index);
     void updateDistanceList(const QString &college);
+    // Offers the round trip and the best trip to each endpoint from the solve behind the
+    // trip on screen, and shows the one the user picks in its place.
+    void chooseTripShape();
+    // Shows a planned trip in the list and starts a new trip session for it.
+    void showPlannedTrip(TripPlanner &planner);
+    // Shows a trip planned by Lock or Auto Tour and keeps its planner for chooseTripShape.
+    void showShapeableTrip(std::unique_ptr<TripPlanner> planner);
+    // Shows the total distance of the trip in progress, noting any estimated legs.
+    void showTotalDistance();
+    void rebuildDistanceGraph();
+    // Logs validation issues from the last imports and, for an import the user asked
+    // for, shows them in a dialog.
+    void reportImportIssues(bool showDialog);
+    // Writes the trip in progress to disk so it can be resumed after a restart.
+    void saveSession();
+    void restoreSession();
+    // Fills the souvenir list from (souvenir, price) pairs.
+    void showSouvenirs(const std::vector<std::pair<QString, double>> &souvenirs);
+    // Shows the souvenirs of a trip stop, from the prefetched catalogs when they are in.
+    void showStopSouvenirs(int position);
+    // Starts loading the souvenirs of every stop of the current trip on a worker thread
+    // (or just forgets the old ones if no trip is active).
+    void prefetchSouvenirs();
+    void onSouvenirsPrefetched(quint64 generation, std::vector<std::vector<std::pair<QString, double>>> catalogs);
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file